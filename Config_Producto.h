@@ -0,0 +1,65 @@
+#pragma once
+
+// =================================================================================
+// PERFIL DE PRODUCTO (VARIANTE / SKU)
+// =================================================================================
+// Define qué funciones opcionales lleva cada imagen. Se elige por build flag en
+// el environment de PlatformIO:
+//
+//   -DPRODUCTO_COMPLETO     (por defecto) todo
+//   -DPRODUCTO_RESIDENCIAL  sin semáforo
+//   -DPRODUCTO_BASICO       solo buzzer de configuración
+//
+// PRODUCTO es constexpr: un 'if (PRODUCTO.x)' se resuelve al compilar y el
+// bloque deshabilitado no genera código (ni sus funciones, por --gc-sections).
+// Los bloques habilitados ya usan los pines y tiempos de Config_Hardware.h y
+// Config.h como constantes.
+// =================================================================================
+
+struct PerfilProducto {
+  bool sirena;
+  bool semaforo;         // PIN_OUT1..3
+  bool buzzer;
+  bool sabotaje;
+  bool panico;
+  bool corrienteMotor;   // Sensor de corriente en PIN_CORRIENTE_MOTOR
+};
+
+#if defined(PRODUCTO_BASICO)
+
+constexpr PerfilProducto PRODUCTO = {
+  /* sirena         */ false,
+  /* semaforo       */ false,
+  /* buzzer         */ true,
+  /* sabotaje       */ false,
+  /* panico         */ false,
+  /* corrienteMotor */ false
+};
+
+#elif defined(PRODUCTO_RESIDENCIAL)
+
+constexpr PerfilProducto PRODUCTO = {
+  /* sirena         */ true,
+  /* semaforo       */ false,
+  /* buzzer         */ true,
+  /* sabotaje       */ true,
+  /* panico         */ true,
+  /* corrienteMotor */ true
+};
+
+#else  // PRODUCTO_COMPLETO
+
+constexpr PerfilProducto PRODUCTO = {
+  /* sirena         */ true,
+  /* semaforo       */ true,
+  /* buzzer         */ true,
+  /* sabotaje       */ true,
+  /* panico         */ true,
+  /* corrienteMotor */ true
+};
+
+#endif
+
+// El sabotaje y el pánico se anuncian con la sirena
+static_assert(!PRODUCTO.sabotaje || PRODUCTO.sirena, "Sabotaje requiere sirena");
+static_assert(!PRODUCTO.panico   || PRODUCTO.sirena, "Panico requiere sirena");
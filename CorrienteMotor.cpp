@@ -0,0 +1,395 @@
+#include "CorrienteMotor.h"
+
+#include "Config_Hardware.h"
+#include "Config_Producto.h"
+
+#include <Preferences.h>
+
+#if ESP_ARDUINO_VERSION_MAJOR < 3
+#include <driver/adc.h>
+#endif
+
+// Sensor de corriente (GPIO36 / ADC1_CH0). Normalmente definido en Config_Hardware.h
+#ifndef PIN_CORRIENTE_MOTOR
+#define PIN_CORRIENTE_MOTOR 36
+#endif
+
+// =================================================================================
+// 1. CONFIGURACIÓN
+// =================================================================================
+#define CORRIENTE_FRECUENCIA_HZ        20000
+#define CORRIENTE_MUESTRAS_BLOQUE      256
+
+#define CORRIENTE_TRAMOS               32     // Resolución de posición de la envolvente
+#define CORRIENTE_TRAMOS_CORRIDA       (2 * CORRIENTE_TRAMOS)   // Hasta 2× el viaje aprendido
+#define CORRIENTE_CORRIDAS_APRENDIZAJE 3
+#define CORRIENTE_MIN_APRENDIDA        100    // Cuentas ADC: sin sensor nunca se arma
+#define CORRIENTE_IGNORAR_INICIO_MS    300    // Arranque del motor
+#define CORRIENTE_MARGEN_ABS           80     // Cuentas ADC sobre la envolvente
+#define CORRIENTE_BLOQUES_CONFIRMA     3      // ≈ 40 ms sostenidos sobre el umbral
+
+// Filtro IIR: valores en Q8, coeficiente 1/4
+#define CORRIENTE_Q                    8
+#define CORRIENTE_SHIFT_IIR            2
+
+#define CORRIENTE_VERSION              1
+#define CORRIENTE_NVS_NAMESPACE        "corriente"
+#define CORRIENTE_NVS_CLAVE            "perfiles"
+
+// =================================================================================
+// 2. VARIABLES
+// =================================================================================
+
+// ---- Compartidas con el loop() (protegidas por mux) ----
+static portMUX_TYPE muxCorriente = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool     enMovimiento   = false;
+static volatile uint32_t idCorrida      = 0;      // +1 en cada inicio de movimiento
+static volatile uint8_t  sentidoActual  = MOTOR_ABRIENDO;
+static volatile uint32_t tInicioMov     = 0;
+static volatile bool     aprendible     = false;  // La corrida actual puede aprenderse
+static volatile bool     finPendiente   = false;  // Corrida terminada, falta procesar
+static volatile bool     finCompleto    = false;
+static volatile uint8_t  sentidoFin     = MOTOR_ABRIENDO;
+static volatile uint32_t duracionFin    = 0;
+static volatile bool     obstruccion    = false;
+
+// ---- Solo de la tarea ----
+struct PerfilSentido {
+  uint16_t envolvente[CORRIENTE_TRAMOS];   // Q0, cuentas ADC
+  uint32_t tiempoViajeMs;
+  uint8_t  corridas;
+};
+
+static PerfilSentido perfiles[2];
+
+// Perfiles aprendidos en flash: sin esto cada reinicio repite el aprendizaje
+struct PerfilesGuardados {
+  uint8_t       version;
+  uint8_t       reservado[3];
+  PerfilSentido perfiles[2];
+};
+
+// Picos de la corrida en tramos del viaje APRENDIDO; al aprender se re-muestrean
+// a la duración medida de esta corrida
+static uint16_t picoCorrida[CORRIENTE_TRAMOS_CORRIDA];
+static uint16_t picoRemuestreado[CORRIENTE_TRAMOS];
+static int32_t  filtrada      = 0;          // Q8
+static uint8_t  bloquesSobre  = 0;
+static uint32_t idProcesada   = 0;
+static bool     armado        = false;      // Monitoreando la corrida actual
+static bool     corridaValida = false;      // Apta para aprender
+
+static TaskHandle_t tareaCorriente = nullptr;
+static uint8_t canalADC = 0;
+
+#if ESP_ARDUINO_VERSION_MAJOR < 3
+static uint8_t bufADC[CORRIENTE_MUESTRAS_BLOQUE * SOC_ADC_DIGI_RESULT_BYTES];
+#endif
+
+// =================================================================================
+// 3. ADC CONTINUO (DMA)
+// =================================================================================
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+
+static void ARDUINO_ISR_ATTR onBloqueADC() {
+  BaseType_t despertar = pdFALSE;
+  vTaskNotifyGiveFromISR(tareaCorriente, &despertar);
+  if (despertar) portYIELD_FROM_ISR();
+}
+
+static void iniciarADC() {
+  uint8_t pines[1] = { PIN_CORRIENTE_MOTOR };
+  analogContinuousSetAtten(ADC_11db);
+  analogContinuous(pines, 1, CORRIENTE_MUESTRAS_BLOQUE, CORRIENTE_FRECUENCIA_HZ, &onBloqueADC);
+  analogContinuousStart();
+}
+
+static bool leerBloque(uint16_t& media) {
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  adc_continuous_data_t* resultado = nullptr;
+  if (!analogContinuousRead(&resultado, 0)) return false;
+  media = resultado[0].avg_read_raw;
+  return true;
+}
+
+#else
+
+static void iniciarADC() {
+
+  adc_digi_init_config_t cfg = {};
+  cfg.max_store_buf_size = sizeof(bufADC) * 4;
+  cfg.conv_num_each_intr = sizeof(bufADC);
+  cfg.adc1_chan_mask     = BIT(canalADC);
+  cfg.adc2_chan_mask     = 0;
+  adc_digi_initialize(&cfg);
+
+  adc_digi_pattern_config_t patron = {};
+  patron.atten     = ADC_ATTEN_DB_11;
+  patron.channel   = canalADC;
+  patron.unit      = 0;                       // ADC1
+  patron.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+
+  adc_digi_configuration_t dig = {};
+  dig.conv_limit_en  = 1;
+  dig.conv_limit_num = 250;
+  dig.pattern_num    = 1;
+  dig.adc_pattern    = &patron;
+  dig.sample_freq_hz = CORRIENTE_FRECUENCIA_HZ;
+  dig.conv_mode      = ADC_CONV_SINGLE_UNIT_1;
+  dig.format         = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+  adc_digi_controller_configure(&dig);
+
+  adc_digi_start();
+}
+
+static bool leerBloque(uint16_t& media) {
+
+  uint32_t leidos = 0;
+  esp_err_t err = adc_digi_read_bytes(bufADC, sizeof(bufADC), &leidos, ADC_MAX_DELAY);
+
+  // INVALID_STATE = el buffer interno se llenó; los datos leídos siguen siendo válidos
+  if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return false;
+
+  uint32_t suma = 0;
+  uint32_t n = 0;
+
+  for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= leidos; i += SOC_ADC_DIGI_RESULT_BYTES) {
+    const adc_digi_output_data_t* p = (const adc_digi_output_data_t*)&bufADC[i];
+    if (p->type1.channel != canalADC) continue;
+    suma += p->type1.data;
+    n++;
+  }
+
+  if (n == 0) return false;
+  media = suma / n;
+  return true;
+}
+
+#endif
+
+// =================================================================================
+// 4. PERSISTENCIA
+// =================================================================================
+static void cargarPerfiles() {
+
+  PerfilesGuardados g;
+  Preferences prefs;
+  if (!prefs.begin(CORRIENTE_NVS_NAMESPACE, true)) return;
+
+  if (prefs.getBytesLength(CORRIENTE_NVS_CLAVE) == sizeof(g)) {
+    prefs.getBytes(CORRIENTE_NVS_CLAVE, &g, sizeof(g));
+    if (g.version == CORRIENTE_VERSION) memcpy(perfiles, g.perfiles, sizeof(perfiles));
+  }
+  prefs.end();
+}
+
+static void guardarPerfiles() {
+
+  PerfilesGuardados g;
+  memset(&g, 0, sizeof(g));
+  g.version = CORRIENTE_VERSION;
+  memcpy(g.perfiles, perfiles, sizeof(perfiles));
+
+  Preferences prefs;
+  if (!prefs.begin(CORRIENTE_NVS_NAMESPACE, false)) return;
+  prefs.putBytes(CORRIENTE_NVS_CLAVE, &g, sizeof(g));
+  prefs.end();
+}
+
+// =================================================================================
+// 5. PROCESAMIENTO (tarea, core 0)
+// =================================================================================
+// Lleva los picos de la corrida (tramos de 'viajeMs') a tramos de su propia
+// duración: cada tramo nuevo toma el máximo de los tramos que cubre. Así solo se
+// usan tramos recorridos, aunque la corrida sea más corta o más larga que el viaje
+// aprendido
+static void remuestrear(uint32_t viajeMs, uint32_t duracionMs) {
+
+  for (uint8_t j = 0; j < CORRIENTE_TRAMOS; j++) {
+    uint32_t desde = (j * duracionMs) / viajeMs;
+    uint32_t hasta = ((j + 1) * duracionMs - 1) / viajeMs;
+    if (desde >= CORRIENTE_TRAMOS_CORRIDA) desde = CORRIENTE_TRAMOS_CORRIDA - 1;
+    if (hasta >= CORRIENTE_TRAMOS_CORRIDA) hasta = CORRIENTE_TRAMOS_CORRIDA - 1;
+
+    uint16_t pico = 0;
+    for (uint32_t i = desde; i <= hasta; i++) {
+      if (picoCorrida[i] > pico) pico = picoCorrida[i];
+    }
+    picoRemuestreado[j] = pico;
+  }
+}
+
+static void aprender(PerfilSentido& perfil, uint32_t duracionMs) {
+
+  if (perfil.corridas == 0) {
+    // Primer viaje: sin tiempo de viaje conocido todos los bloques cayeron en el
+    // último tramo. Solo se aprende la duración; la envolvente arranca en el 2º
+    perfil.tiempoViajeMs = duracionMs;
+  } else if (perfil.corridas == 1) {
+    remuestrear(perfil.tiempoViajeMs, duracionMs);
+    memcpy(perfil.envolvente, picoRemuestreado, sizeof(picoRemuestreado));
+    perfil.tiempoViajeMs = (perfil.tiempoViajeMs + duracionMs) / 2;
+  } else {
+    // Promedio móvil 3/4 + 1/4 hacia la última corrida
+    remuestrear(perfil.tiempoViajeMs, duracionMs);
+    for (uint8_t i = 0; i < CORRIENTE_TRAMOS; i++) {
+      perfil.envolvente[i] = (perfil.envolvente[i] * 3 + picoRemuestreado[i]) / 4;
+    }
+    perfil.tiempoViajeMs = (perfil.tiempoViajeMs * 3 + duracionMs) / 4;
+  }
+
+  if (perfil.corridas < 255) perfil.corridas++;
+
+  // Una escritura por viaje aprendido, desde la tarea y no desde el loop()
+  guardarPerfiles();
+}
+
+static bool perfilListo(const PerfilSentido& perfil) {
+  if (perfil.corridas < CORRIENTE_CORRIDAS_APRENDIZAJE) return false;
+
+  uint16_t maximo = 0;
+  for (uint8_t i = 0; i < CORRIENTE_TRAMOS; i++) {
+    if (perfil.envolvente[i] > maximo) maximo = perfil.envolvente[i];
+  }
+  return maximo >= CORRIENTE_MIN_APRENDIDA;
+}
+
+static void procesarBloque(uint16_t media) {
+
+  // ---- Eventos del loop() ----
+  bool     mov, fin, completo, nuevaAprendible;
+  uint8_t  sentido, sentidoTerminado;
+  uint32_t id, tInicio, duracion;
+
+  portENTER_CRITICAL(&muxCorriente);
+  mov      = enMovimiento;
+  id       = idCorrida;
+  sentido  = sentidoActual;
+  tInicio  = tInicioMov;
+  nuevaAprendible = aprendible;
+  fin      = finPendiente;
+  completo = finCompleto;
+  sentidoTerminado = sentidoFin;
+  duracion = duracionFin;
+  finPendiente = false;
+  portEXIT_CRITICAL(&muxCorriente);
+
+  // Corrida terminada: se aprende solo si llegó al final de carrera sin obstrucción
+  if (fin) {
+    if (completo && corridaValida) aprender(perfiles[sentidoTerminado], duracion);
+    corridaValida = false;
+    armado = false;
+  }
+
+  // ---- Filtro IIR (siempre corriendo para no arrancar de cero) ----
+  int32_t entrada = (int32_t)media << CORRIENTE_Q;
+  filtrada += (entrada - filtrada) >> CORRIENTE_SHIFT_IIR;
+
+  if (!mov) return;
+
+  // Nueva corrida
+  if (id != idProcesada) {
+    idProcesada = id;
+    memset(picoCorrida, 0, sizeof(picoCorrida));
+    corridaValida = nuevaAprendible;
+    armado = true;
+    bloquesSobre = 0;
+  }
+
+  PerfilSentido& perfil = perfiles[sentido];
+  uint32_t transcurrido = millis() - tInicio;
+
+  // ---- Posición estimada en el recorrido ----
+  uint32_t viaje = perfil.tiempoViajeMs ? perfil.tiempoViajeMs : 1;
+  uint32_t tramoCorrida = (transcurrido * CORRIENTE_TRAMOS) / viaje;
+  if (tramoCorrida >= CORRIENTE_TRAMOS_CORRIDA) tramoCorrida = CORRIENTE_TRAMOS_CORRIDA - 1;
+  uint32_t tramo = (tramoCorrida < CORRIENTE_TRAMOS) ? tramoCorrida : CORRIENTE_TRAMOS - 1;
+
+  uint16_t valor = (uint16_t)(filtrada >> CORRIENTE_Q);
+  if (valor > picoCorrida[tramoCorrida]) picoCorrida[tramoCorrida] = valor;
+
+  // ---- Detección ----
+  if (!armado || !perfilListo(perfil)) return;
+  if (transcurrido < CORRIENTE_IGNORAR_INICIO_MS) return;
+
+  uint16_t env    = perfil.envolvente[tramo];
+  uint32_t umbral = env + env / 4 + CORRIENTE_MARGEN_ABS;
+
+  if (valor > umbral) {
+    if (++bloquesSobre >= CORRIENTE_BLOQUES_CONFIRMA) {
+      armado = false;            // Desarmado hasta el próximo movimiento
+      corridaValida = false;     // Una corrida obstruida no se aprende
+      obstruccion = true;
+    }
+  } else {
+    bloquesSobre = 0;
+  }
+}
+
+static void tareaCorrienteMotor(void*) {
+
+  iniciarADC();
+
+  for (;;) {
+    uint16_t media;
+    if (leerBloque(media)) procesarBloque(media);
+  }
+}
+
+// =================================================================================
+// 6. API
+// =================================================================================
+void CorrienteMotor_begin() {
+
+  if (!PRODUCTO.corrienteMotor) return;
+
+  int8_t canal = digitalPinToAnalogChannel(PIN_CORRIENTE_MOTOR);
+  if (canal < 0 || canal > 7) return;   // Solo ADC1 (ADC2 lo usa el WiFi)
+  canalADC = (uint8_t)canal;
+
+  memset(perfiles, 0, sizeof(perfiles));
+  cargarPerfiles();
+
+  // Core 0: el loop() de Arduino corre en el core 1
+  xTaskCreatePinnedToCore(tareaCorrienteMotor, "corriente", 3072, nullptr, 5,
+                          &tareaCorriente, 0);
+}
+
+static void cerrarCorrida(bool viajeCompleto) {
+  // Llamar con muxCorriente tomado
+  if (!enMovimiento) return;
+  finPendiente = true;
+  finCompleto  = viajeCompleto;
+  sentidoFin   = sentidoActual;
+  duracionFin  = millis() - tInicioMov;
+  enMovimiento = false;
+}
+
+void CorrienteMotor_inicioMovimiento(SentidoMotor sentido, bool aprendibleCorrida) {
+  portENTER_CRITICAL(&muxCorriente);
+  cerrarCorrida(false);       // Cambio de sentido sin pasar por un final de carrera
+  sentidoActual = sentido;
+  tInicioMov    = millis();
+  aprendible    = aprendibleCorrida;
+  idCorrida     = idCorrida + 1;
+  enMovimiento  = true;
+  obstruccion   = false;
+  portEXIT_CRITICAL(&muxCorriente);
+}
+
+void CorrienteMotor_finMovimiento(bool viajeCompleto) {
+  portENTER_CRITICAL(&muxCorriente);
+  cerrarCorrida(viajeCompleto);
+  portEXIT_CRITICAL(&muxCorriente);
+}
+
+bool CorrienteMotor_obstruccion() {
+  if (!obstruccion) return false;
+
+  portENTER_CRITICAL(&muxCorriente);
+  bool hubo = obstruccion;
+  obstruccion = false;
+  portEXIT_CRITICAL(&muxCorriente);
+
+  return hubo;
+}
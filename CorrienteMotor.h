@@ -0,0 +1,45 @@
+#pragma once
+
+// =================================================================================
+// CORRIENTE DE MOTOR – DETECCIÓN DE OBSTRUCCIÓN
+// =================================================================================
+// El ADC muestrea la corriente del motor en modo continuo (DMA), sin intervención
+// del loop(). Una tarea en el core 0 procesa los bloques:
+//
+//   1. Media del bloque (256 muestras a 20 kHz ≈ 13 ms)
+//   2. Filtro IIR en punto fijo
+//   3. Comparación contra la ENVOLVENTE aprendida para esa posición del recorrido
+//
+// La posición se estima por tiempo dentro del viaje (en tramos). La envolvente se
+// aprende por sentido con cada viaje completo sin obstrucción: el primero solo
+// mide la duración (sin ella no hay posición) y la envolvente se arma desde el
+// segundo, re-muestreando cada viaje a su propia duración. Hasta tener
+// CORRIENTE_CORRIDAS_APRENDIZAJE viajes la detección no se arma. Los perfiles se
+// guardan en NVS tras cada viaje aprendido.
+//
+// Al detectar un pico, el loop() recibe la obstrucción en la próxima vuelta y
+// actúa igual que la barrera. Tras una detección el módulo se desarma hasta el
+// próximo movimiento (el portón puede estar invirtiendo).
+//
+// PIN_CORRIENTE_MOTOR debe ser un pin del ADC1 (Config_Hardware.h).
+// =================================================================================
+
+#include <Arduino.h>
+
+enum SentidoMotor {
+  MOTOR_ABRIENDO,
+  MOTOR_CERRANDO
+};
+
+void CorrienteMotor_begin();
+
+// Llamados desde el loop() en cada cambio de estado del portón.
+// aprendible = false: comando a mitad de viaje (parada / inversión). Rearma la
+// detección desde cero pero esa corrida no se usa para aprender. Los pulsos de
+// la barrera o de la propia obstrucción no rearman: el loop() llama a
+// finMovimiento(false) y el módulo queda desarmado hasta el próximo estado.
+void CorrienteMotor_inicioMovimiento(SentidoMotor sentido, bool aprendible = true);
+void CorrienteMotor_finMovimiento(bool viajeCompleto);
+
+// true una sola vez por detección
+bool CorrienteMotor_obstruccion();
@@ -0,0 +1,96 @@
+#include "Diagnostico.h"
+
+#ifdef DIAG_LOOP
+
+// =================================================================================
+// 1. VARIABLES
+// =================================================================================
+struct MedicionBloque {
+  uint32_t ciclosSuma;    // Ventana actual
+  uint32_t ciclosMax;     // Ventana actual
+  uint32_t peorCaso;      // Desde el arranque
+};
+
+static const char* const nombresBloque[CANTIDAD_BLOQUES_DIAG] = {
+  "Entradas",
+  "Barrera",
+  "Estado",
+  "Seguridad",
+  "Actuadores",
+  "Indicadores",
+  "Servicios",
+  "LOOP"
+};
+
+static MedicionBloque mediciones[CANTIDAD_BLOQUES_DIAG];
+static uint32_t cicloInicioLoop = 0;
+static uint32_t cicloMarca      = 0;
+static uint32_t vueltas         = 0;
+static uint32_t violaciones     = 0;
+static unsigned long tReporte   = 0;
+
+// =================================================================================
+// 2. HELPERS
+// =================================================================================
+static void acumular(BloqueDiag bloque, uint32_t ciclos) {
+  MedicionBloque& m = mediciones[bloque];
+  m.ciclosSuma += ciclos;
+  if (ciclos > m.ciclosMax) m.ciclosMax = ciclos;
+  if (ciclos > m.peorCaso)  m.peorCaso  = ciclos;
+}
+
+static void reportar() {
+
+  uint32_t mhz = ESP.getCpuFreqMHz();
+
+  Serial.printf("[DIAG] %lu vueltas, %lu violaciones\n",
+                (unsigned long)vueltas, (unsigned long)violaciones);
+
+  for (uint8_t i = 0; i < CANTIDAD_BLOQUES_DIAG; i++) {
+    MedicionBloque& m = mediciones[i];
+    uint32_t prom = vueltas ? (m.ciclosSuma / vueltas) : 0;
+
+    Serial.printf("[DIAG] %-11s prom %6lu ciclos (%4lu us)  max %7lu (%5lu us)  peor %7lu (%5lu us)\n",
+                  nombresBloque[i],
+                  (unsigned long)prom,        (unsigned long)(prom / mhz),
+                  (unsigned long)m.ciclosMax, (unsigned long)(m.ciclosMax / mhz),
+                  (unsigned long)m.peorCaso,  (unsigned long)(m.peorCaso / mhz));
+
+    m.ciclosSuma = 0;
+    m.ciclosMax  = 0;
+  }
+
+  vueltas = 0;
+}
+
+// =================================================================================
+// 3. API
+// =================================================================================
+void Diag_inicio() {
+  cicloInicioLoop = ESP.getCycleCount();
+  cicloMarca = cicloInicioLoop;
+}
+
+void Diag_marca(BloqueDiag bloque) {
+  uint32_t ahora = ESP.getCycleCount();
+  acumular(bloque, ahora - cicloMarca);
+  cicloMarca = ahora;
+}
+
+void Diag_fin() {
+
+  acumular(DIAG_LOOP_COMPLETO, ESP.getCycleCount() - cicloInicioLoop);
+  vueltas++;
+
+  if (millis() - tReporte >= DIAG_PERIODO_REPORTE_MS) {
+    tReporte = millis();
+    reportar();
+  }
+}
+
+void Diag_violacion(const char* regla) {
+  violaciones++;
+  Serial.printf("[DIAG] VIOLACION: %s (t=%lu ms)\n", regla, millis());
+}
+
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+
+// =================================================================================
+// DIAGNÓSTICO – COSTO POR BLOQUE E INVARIANTES DE SEGURIDAD
+// =================================================================================
+// Solo se compila con el flag de build DIAG_LOOP (build_flags = -DDIAG_LOOP).
+// En la imagen de producción las macros quedan vacías: costo cero.
+//
+// Con DIAG_LOOP activo:
+//   - Se miden ciclos de CPU de cada etapa del loop() (promedio y peor caso)
+//   - main.cpp verifica invariantes de seguridad en cada vuelta
+//   - Cada DIAG_PERIODO_REPORTE_MS se imprime un resumen por Serial
+// =================================================================================
+
+#include <Arduino.h>
+
+#define DIAG_PERIODO_REPORTE_MS 10000UL
+
+// ===================== ETAPAS DEL LOOP ====================
+enum BloqueDiag {
+  DIAG_ENTRADAS,
+  DIAG_BARRERA,
+  DIAG_ESTADO,
+  DIAG_SEGURIDAD,
+  DIAG_ACTUADORES,
+  DIAG_INDICADORES,
+  DIAG_SERVICIOS,
+  DIAG_LOOP_COMPLETO,
+  CANTIDAD_BLOQUES_DIAG
+};
+
+#ifdef DIAG_LOOP
+
+void Diag_inicio();                    // Comienzo de loop()
+void Diag_marca(BloqueDiag bloque);    // Cierra la etapa que terminó recién
+void Diag_fin();                       // Cierra loop() completo y reporta
+void Diag_violacion(const char* regla);
+
+#define DIAG_INICIO()    Diag_inicio()
+#define DIAG_MARCA(b)    Diag_marca(b)
+#define DIAG_FIN()       Diag_fin()
+
+#else
+
+#define DIAG_INICIO()
+#define DIAG_MARCA(b)
+#define DIAG_FIN()
+
+#endif
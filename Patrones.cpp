@@ -0,0 +1,224 @@
+#include "Patrones.h"
+
+#include "Config.h"
+#include "Config_Hardware.h"
+#include "Config_Producto.h"
+
+// LED de configuración (GPIO22). Normalmente definido en Config_Hardware.h
+#ifndef PIN_LED_CONFIG
+#define PIN_LED_CONFIG 22
+#endif
+
+#define MS_A_TICKS(ms) ((uint16_t)(((ms) + PATRON_TICK_MS - 1) / PATRON_TICK_MS))
+#define PASOS(tabla)   tabla, (uint8_t)(sizeof(tabla) / sizeof(tabla[0]))
+
+static_assert(SIRENA_ON_TIEMPO    / PATRON_TICK_MS <= 0xFFFF, "SIRENA_ON_TIEMPO excede el tick");
+static_assert(SIRENA_OFF_TIEMPO   / PATRON_TICK_MS <= 0xFFFF, "SIRENA_OFF_TIEMPO excede el tick");
+static_assert(DURACION_BEEP_ERROR / PATRON_TICK_MS <= 0xFFFF, "DURACION_BEEP_ERROR excede el tick");
+
+// =================================================================================
+// 1. TABLAS DE PATRONES
+// =================================================================================
+
+// ===================== SIRENA =============================
+static const PasoPatron pasosSirenaAlarma[] = {
+  { HIGH, MS_A_TICKS(SIRENA_ON_TIEMPO)  },
+  { LOW,  MS_A_TICKS(SIRENA_OFF_TIEMPO) }
+};
+static const PasoPatron pasosSirenaContinua[] = {
+  { HIGH, 0xFFFF }
+};
+static const PasoPatron pasosBeepError[] = {
+  { HIGH, MS_A_TICKS(DURACION_BEEP_ERROR) }
+};
+
+const Patron PATRON_SIRENA_ALARMA   = { PASOS(pasosSirenaAlarma),   true  };
+const Patron PATRON_SIRENA_CONTINUA = { PASOS(pasosSirenaContinua), true  };
+const Patron PATRON_BEEP_ERROR      = { PASOS(pasosBeepError),      false };
+
+// ===================== BUZZER =============================
+static const PasoPatron pasosBeep[] = {
+  { HIGH, MS_A_TICKS(120) },
+  { LOW,  MS_A_TICKS(120) }
+};
+
+const Patron PATRON_BEEP = { PASOS(pasosBeep), false };
+
+// ===================== LEDS ===============================
+static const PasoPatron pasosHeartbeat[] = {
+  { HIGH, MS_A_TICKS(1000) },
+  { LOW,  MS_A_TICKS(1000) }
+};
+
+// Confirmación de nivel del botón PROG: N destellos y pausa
+static const PasoPatron pasosLedCfg1[] = {
+  { HIGH, MS_A_TICKS(150) }, { LOW, MS_A_TICKS(1000) }
+};
+static const PasoPatron pasosLedCfg2[] = {
+  { HIGH, MS_A_TICKS(150) }, { LOW, MS_A_TICKS(150) },
+  { HIGH, MS_A_TICKS(150) }, { LOW, MS_A_TICKS(1000) }
+};
+static const PasoPatron pasosLedCfg3[] = {
+  { HIGH, MS_A_TICKS(150) }, { LOW, MS_A_TICKS(150) },
+  { HIGH, MS_A_TICKS(150) }, { LOW, MS_A_TICKS(150) },
+  { HIGH, MS_A_TICKS(150) }, { LOW, MS_A_TICKS(1000) }
+};
+static const PasoPatron pasosLedCfg4[] = {
+  { HIGH, MS_A_TICKS(150) }, { LOW, MS_A_TICKS(150) },
+  { HIGH, MS_A_TICKS(150) }, { LOW, MS_A_TICKS(150) },
+  { HIGH, MS_A_TICKS(150) }, { LOW, MS_A_TICKS(150) },
+  { HIGH, MS_A_TICKS(150) }, { LOW, MS_A_TICKS(1000) }
+};
+static const PasoPatron pasosLedCfgLearn[] = {
+  { HIGH, MS_A_TICKS(500) },
+  { LOW,  MS_A_TICKS(500) }
+};
+static const PasoPatron pasosLedCfgSalida[] = {
+  { HIGH, MS_A_TICKS(50) },
+  { LOW,  MS_A_TICKS(50) }
+};
+
+const Patron PATRON_HEARTBEAT     = { PASOS(pasosHeartbeat),    true };
+const Patron PATRON_LEDCFG_1S     = { PASOS(pasosLedCfg1),      true };
+const Patron PATRON_LEDCFG_5S     = { PASOS(pasosLedCfg2),      true };
+const Patron PATRON_LEDCFG_10S    = { PASOS(pasosLedCfg3),      true };
+const Patron PATRON_LEDCFG_15S    = { PASOS(pasosLedCfg4),      true };
+const Patron PATRON_LEDCFG_LEARN  = { PASOS(pasosLedCfgLearn),  true };
+const Patron PATRON_LEDCFG_SALIDA = { PASOS(pasosLedCfgSalida), false };
+
+// =================================================================================
+// 2. ESTADO DE CANALES
+// =================================================================================
+struct CanalEstado {
+  const Patron* patron;       // nullptr = detenido
+  uint8_t  paso;
+  uint8_t  repeticiones;      // 0 = infinito
+  uint16_t restante;          // ticks que faltan del paso actual
+  uint8_t  nivel;
+};
+
+static const uint8_t pinesCanal[CANTIDAD_CANALES] = {
+  PIN_SIRENA,
+  PIN_BUZZER,
+  PIN_LED_VERDE,
+  PIN_LED_CONFIG
+};
+
+// Canales sin hardware en esta variante: no se configuran ni se manejan
+static constexpr bool canalHabilitado[CANTIDAD_CANALES] = {
+  PRODUCTO.sirena,
+  PRODUCTO.buzzer,
+  true,
+  true
+};
+
+static volatile CanalEstado canales[CANTIDAD_CANALES];
+static portMUX_TYPE muxPatrones = portMUX_INITIALIZER_UNLOCKED;
+static hw_timer_t*  timerPatrones = nullptr;
+
+// =================================================================================
+// 3. ISR DEL TIMER
+// =================================================================================
+static void IRAM_ATTR onTickPatrones() {
+
+  portENTER_CRITICAL_ISR(&muxPatrones);
+
+  for (uint8_t i = 0; i < CANTIDAD_CANALES; i++) {
+
+    volatile CanalEstado& c = canales[i];
+    if (c.patron == nullptr) continue;
+    if (--c.restante > 0) continue;
+
+    // Fin del paso → siguiente
+    c.paso++;
+    if (c.paso >= c.patron->cantidad) {
+      c.paso = 0;
+
+      if (c.repeticiones > 0 && --c.repeticiones == 0) {
+        c.patron = nullptr;
+        c.nivel = LOW;
+        digitalWrite(pinesCanal[i], LOW);
+        continue;
+      }
+    }
+
+    const PasoPatron& p = c.patron->pasos[c.paso];
+    c.restante = p.ticks;
+    if (p.nivel != c.nivel) {
+      c.nivel = p.nivel;
+      digitalWrite(pinesCanal[i], p.nivel);
+    }
+  }
+
+  portEXIT_CRITICAL_ISR(&muxPatrones);
+}
+
+// =================================================================================
+// 4. API
+// =================================================================================
+void Patrones_begin() {
+
+  for (uint8_t i = 0; i < CANTIDAD_CANALES; i++) {
+    canales[i].patron = nullptr;
+    canales[i].nivel  = LOW;
+    if (!canalHabilitado[i]) continue;
+
+    pinMode(pinesCanal[i], OUTPUT);
+    digitalWrite(pinesCanal[i], LOW);
+  }
+
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+  timerPatrones = timerBegin(1000000);                       // 1 MHz
+  timerAttachInterrupt(timerPatrones, &onTickPatrones);
+  timerAlarm(timerPatrones, PATRON_TICK_MS * 1000, true, 0);
+#else
+  timerPatrones = timerBegin(0, 80, true);                   // 80 MHz / 80 = 1 MHz
+  timerAttachInterrupt(timerPatrones, &onTickPatrones, true);
+  timerAlarmWrite(timerPatrones, PATRON_TICK_MS * 1000, true);
+  timerAlarmEnable(timerPatrones);
+#endif
+}
+
+void Patron_reproducir(CanalPatron canal, const Patron& patron, uint8_t repeticiones) {
+
+  if (!canalHabilitado[canal]) return;
+  if (repeticiones == 0 && !patron.repetir) repeticiones = 1;
+
+  portENTER_CRITICAL(&muxPatrones);
+
+  volatile CanalEstado& c = canales[canal];
+  c.patron       = &patron;
+  c.paso         = 0;
+  c.repeticiones = repeticiones;
+  c.restante     = patron.pasos[0].ticks;
+  c.nivel        = patron.pasos[0].nivel;
+  digitalWrite(pinesCanal[canal], c.nivel);
+
+  portEXIT_CRITICAL(&muxPatrones);
+}
+
+void Patron_mantener(CanalPatron canal, const Patron& patron) {
+  if (canales[canal].patron == &patron) return;
+  Patron_reproducir(canal, patron);
+}
+
+void Patron_detener(CanalPatron canal) {
+
+  if (canales[canal].patron == nullptr) return;
+
+  portENTER_CRITICAL(&muxPatrones);
+
+  canales[canal].patron = nullptr;
+  canales[canal].nivel  = LOW;
+  digitalWrite(pinesCanal[canal], LOW);
+
+  portEXIT_CRITICAL(&muxPatrones);
+}
+
+bool Patron_activo(CanalPatron canal) {
+  return canales[canal].patron != nullptr;
+}
+
+bool Patron_nivel(CanalPatron canal) {
+  return canales[canal].nivel == HIGH;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+// =================================================================================
+// PATRONES – SECUENCIADOR POR TEMPORIZADOR DE HARDWARE
+// =================================================================================
+// Sirena, buzzer y LEDs reproducen cadencias declaradas como tablas constantes.
+// Un único timer de hardware (tick de 10 ms) avanza todos los canales desde su
+// ISR: una vez iniciado un patrón, el loop() no gasta nada y la cadencia no se
+// corre aunque el loop venga cargado.
+//
+// Cada paso es { nivel, duración en ticks }. Un patrón se repite 'repeticiones'
+// veces (0 = según el patrón: infinito si 'repetir', una vez si no) y al
+// terminar deja la salida en LOW.
+// =================================================================================
+
+#include <Arduino.h>
+
+#define PATRON_TICK_MS 10
+
+// ===================== CANALES ============================
+enum CanalPatron {
+  CANAL_SIRENA,
+  CANAL_BUZZER,
+  CANAL_LED_VERDE,
+  CANAL_LED_CONFIG,
+  CANTIDAD_CANALES
+};
+
+// ===================== TABLAS =============================
+struct PasoPatron {
+  uint8_t  nivel;
+  uint16_t ticks;
+};
+
+struct Patron {
+  const PasoPatron* pasos;
+  uint8_t cantidad;
+  bool    repetir;
+};
+
+// === Sirena ===
+extern const Patron PATRON_SIRENA_ALARMA;    // SIRENA_ON_TIEMPO / SIRENA_OFF_TIEMPO
+extern const Patron PATRON_SIRENA_CONTINUA;  // Pánico enclavado
+extern const Patron PATRON_BEEP_ERROR;       // DURACION_BEEP_ERROR, una vez
+
+// === Buzzer ===
+extern const Patron PATRON_BEEP;             // 120 ms ON / 120 ms OFF
+
+// === LEDs ===
+extern const Patron PATRON_HEARTBEAT;        // 1 Hz
+extern const Patron PATRON_LEDCFG_1S;        // 1 destello + pausa
+extern const Patron PATRON_LEDCFG_5S;        // 2 destellos + pausa
+extern const Patron PATRON_LEDCFG_10S;       // 3 destellos + pausa
+extern const Patron PATRON_LEDCFG_15S;       // 4 destellos + pausa
+extern const Patron PATRON_LEDCFG_LEARN;     // Parpadeo lento continuo
+extern const Patron PATRON_LEDCFG_SALIDA;    // Destello rápido ~1 s
+
+// ===================== API ================================
+void Patrones_begin();  // Pines de salida + timer de hardware
+
+// Inicia (o reinicia) el patrón en el canal
+void Patron_reproducir(CanalPatron canal, const Patron& patron, uint8_t repeticiones = 0);
+
+// Inicia el patrón solo si el canal no lo está reproduciendo ya
+void Patron_mantener(CanalPatron canal, const Patron& patron);
+
+// Corta el canal y deja la salida en LOW
+void Patron_detener(CanalPatron canal);
+
+bool Patron_activo(CanalPatron canal);
+bool Patron_nivel(CanalPatron canal);
@@ -0,0 +1,282 @@
+#include "ProtocoloUDP.h"
+
+#include "secrets.h"
+
+#ifdef UDP_CLAVE
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include <mbedtls/md.h>
+#include <esp_system.h>
+
+#include "Config_Hardware.h"
+#include "Telemetria.h"
+
+// =================================================================================
+// 1. CONFIGURACIÓN
+// =================================================================================
+#ifndef UDP_PUERTO
+#define UDP_PUERTO 4210
+#endif
+
+#ifndef UDP_MULTICAST_IP
+#define UDP_MULTICAST_IP "239.255.42.1"
+#endif
+
+#ifndef UDP_MULTICAST_PUERTO
+#define UDP_MULTICAST_PUERTO 4211
+#endif
+
+#define UDP_MAX_TRAMAS_POR_LOOP  4     // Acota el tiempo por vuelta de loop()
+#define UDP_MIN_ENTRE_AVISOS_MS  100   // Evita inundar el grupo si algo rebota
+
+// =================================================================================
+// 2. ESTADO DEL SISTEMA (main.cpp)
+// =================================================================================
+extern int  estadoPortonUI;
+extern int  estadoSeguridadUI;
+extern char ultimoUsuario[20];
+extern bool solicitudPulso;
+extern bool panicoEnclavado;
+extern bool emergenciaActiva;
+extern bool modoMantenimiento;
+
+void registrarEvento(String msg, String userForzado);
+
+// =================================================================================
+// 3. VARIABLES
+// =================================================================================
+static int sock = -1;
+static struct sockaddr_in destinoMulticast;
+
+static mbedtls_md_context_t ctxHmac;
+static bool hmacListo = false;
+
+static uint32_t sesion          = 0;
+static uint32_t ultimaSecuencia = 0;
+static uint32_t secuenciaAviso  = 0;
+
+static uint8_t bufRx[64];
+
+// Último estado avisado por multicast
+static uint8_t portonAvisado    = 0xFF;
+static uint8_t seguridadAvisada = 0xFF;
+static uint8_t flagsAvisados    = 0xFF;
+static unsigned long tUltimoAviso = 0;
+
+// =================================================================================
+// 4. HELPERS
+// =================================================================================
+static void calcularMac(const void* datos, size_t largo, uint8_t* mac) {
+  uint8_t completo[32];
+  mbedtls_md_hmac_reset(&ctxHmac);
+  mbedtls_md_hmac_update(&ctxHmac, (const uint8_t*)datos, largo);
+  mbedtls_md_hmac_finish(&ctxHmac, completo);
+  memcpy(mac, completo, UDP_LARGO_MAC);
+}
+
+// Comparación en tiempo constante
+static bool macValida(const void* datos, size_t largo, const uint8_t* mac) {
+  uint8_t esperada[UDP_LARGO_MAC];
+  calcularMac(datos, largo, esperada);
+
+  uint8_t dif = 0;
+  for (uint8_t i = 0; i < UDP_LARGO_MAC; i++) dif |= esperada[i] ^ mac[i];
+  return dif == 0;
+}
+
+static void armarCabecera(CabeceraUDP& cab, TipoTramaUDP tipo, uint32_t secuencia) {
+  cab.magia[0]  = 'P';
+  cab.magia[1]  = 'U';
+  cab.version   = UDP_VERSION_PROTOCOLO;
+  cab.tipo      = tipo;
+  cab.sesion    = sesion;
+  cab.secuencia = secuencia;
+}
+
+static bool cabeceraValida(const CabeceraUDP& cab) {
+  return cab.magia[0] == 'P' && cab.magia[1] == 'U' &&
+         cab.version == UDP_VERSION_PROTOCOLO;
+}
+
+static uint8_t flagsActuales() {
+  uint8_t f = 0;
+  if (panicoEnclavado)                    f |= UDP_FLAG_PANICO;
+  if (emergenciaActiva)                   f |= UDP_FLAG_EMERGENCIA;
+  if (modoMantenimiento)                  f |= UDP_FLAG_MANTENIMIENTO;
+  if (digitalRead(PIN_BARRERA) == HIGH)   f |= UDP_FLAG_BARRERA;
+  return f;
+}
+
+static void armarEstado(TramaEstadoUDP& t, uint32_t secuencia) {
+  armarCabecera(t.cab, UDP_ESTADO, secuencia);
+  t.estadoPorton    = (uint8_t)estadoPortonUI;
+  t.estadoSeguridad = (uint8_t)estadoSeguridadUI;
+  t.flags           = flagsActuales();
+  t.reservado       = 0;
+  strncpy(t.ultimoUsuario, ultimoUsuario, sizeof(t.ultimoUsuario));
+  t.ciclos  = Telemetria_totalCiclos();
+  t.alarmas = Telemetria_totalAlarmas();
+  t.uptime  = millis() / 1000;
+  calcularMac(&t, sizeof(t) - UDP_LARGO_MAC, t.mac);
+}
+
+static void enviar(const void* trama, size_t largo, const struct sockaddr_in& destino) {
+  sendto(sock, trama, largo, 0, (const struct sockaddr*)&destino, sizeof(destino));
+}
+
+// =================================================================================
+// 5. SOCKET
+// =================================================================================
+static bool abrirSocket() {
+
+  sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (sock < 0) return false;
+
+  struct sockaddr_in local;
+  memset(&local, 0, sizeof(local));
+  local.sin_family      = AF_INET;
+  local.sin_port        = htons(UDP_PUERTO);
+  local.sin_addr.s_addr = htonl(INADDR_ANY);
+
+  if (bind(sock, (struct sockaddr*)&local, sizeof(local)) < 0) {
+    close(sock);
+    sock = -1;
+    return false;
+  }
+
+  fcntl(sock, F_SETFL, O_NONBLOCK);
+
+  // Tras reconectar se vuelve a avisar el estado completo
+  portonAvisado = seguridadAvisada = flagsAvisados = 0xFF;
+  return true;
+}
+
+static void cerrarSocket() {
+  if (sock < 0) return;
+  close(sock);
+  sock = -1;
+}
+
+// =================================================================================
+// 6. ATENCIÓN DE TRAMAS
+// =================================================================================
+static void atenderConsulta(const TramaConsultaUDP& t, const struct sockaddr_in& origen) {
+
+  if (!macValida(&t, sizeof(t) - UDP_LARGO_MAC, t.mac)) return;
+
+  TramaEstadoUDP resp;
+  armarEstado(resp, t.cab.secuencia);
+  enviar(&resp, sizeof(resp), origen);
+}
+
+static void atenderComando(const TramaComandoUDP& t, const struct sockaddr_in& origen) {
+
+  if (!macValida(&t, sizeof(t) - UDP_LARGO_MAC, t.mac)) return;
+
+  ResultadoUDP resultado;
+
+  if (t.cab.sesion != sesion)                 resultado = UDP_ACK_SESION;
+  else if (t.cab.secuencia == ultimaSecuencia) resultado = UDP_ACK_DUPLICADO;
+  else if (t.cab.secuencia <  ultimaSecuencia) resultado = UDP_ACK_VIEJO;
+  else if (t.comando != UDP_CMD_PULSO)         resultado = UDP_ACK_DESCONOCIDO;
+  else {
+    ultimaSecuencia = t.cab.secuencia;
+    strcpy(ultimoUsuario, "Integracion UDP");
+    solicitudPulso = true;
+    registrarEvento("Comando UDP", "Integracion UDP");
+    resultado = UDP_ACK_ACEPTADO;
+  }
+
+  TramaAckUDP ack;
+  armarCabecera(ack.cab, UDP_ACK, t.cab.secuencia);
+  ack.resultado = resultado;
+  memset(ack.reservado, 0, sizeof(ack.reservado));
+  calcularMac(&ack, sizeof(ack) - UDP_LARGO_MAC, ack.mac);
+  enviar(&ack, sizeof(ack), origen);
+}
+
+static void avisarCambios() {
+
+  uint8_t porton    = (uint8_t)estadoPortonUI;
+  uint8_t seguridad = (uint8_t)estadoSeguridadUI;
+  uint8_t flags     = flagsActuales();
+
+  if (porton == portonAvisado && seguridad == seguridadAvisada && flags == flagsAvisados) return;
+  if (millis() - tUltimoAviso < UDP_MIN_ENTRE_AVISOS_MS) return;
+
+  TramaEstadoUDP t;
+  armarEstado(t, ++secuenciaAviso);
+  enviar(&t, sizeof(t), destinoMulticast);
+
+  portonAvisado    = porton;
+  seguridadAvisada = seguridad;
+  flagsAvisados    = flags;
+  tUltimoAviso     = millis();
+}
+
+// =================================================================================
+// 7. API
+// =================================================================================
+void ProtocoloUDP_begin() {
+
+  sesion = esp_random();
+
+  // Contexto HMAC: única reserva de memoria, al arrancar
+  mbedtls_md_init(&ctxHmac);
+  if (mbedtls_md_setup(&ctxHmac, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 1) == 0 &&
+      mbedtls_md_hmac_starts(&ctxHmac, (const uint8_t*)UDP_CLAVE, strlen(UDP_CLAVE)) == 0) {
+    hmacListo = true;
+  }
+
+  memset(&destinoMulticast, 0, sizeof(destinoMulticast));
+  destinoMulticast.sin_family      = AF_INET;
+  destinoMulticast.sin_port        = htons(UDP_MULTICAST_PUERTO);
+  destinoMulticast.sin_addr.s_addr = inet_addr(UDP_MULTICAST_IP);
+}
+
+void ProtocoloUDP_loop() {
+
+  if (!hmacListo) return;
+
+  if (WiFi.status() != WL_CONNECTED) {
+    cerrarSocket();
+    return;
+  }
+
+  if (sock < 0 && !abrirSocket()) return;
+
+  for (uint8_t i = 0; i < UDP_MAX_TRAMAS_POR_LOOP; i++) {
+
+    struct sockaddr_in origen;
+    socklen_t largoOrigen = sizeof(origen);
+
+    int n = recvfrom(sock, bufRx, sizeof(bufRx), MSG_DONTWAIT,
+                     (struct sockaddr*)&origen, &largoOrigen);
+    if (n <= 0) break;
+    if ((size_t)n < sizeof(CabeceraUDP)) continue;
+
+    const CabeceraUDP* cab = (const CabeceraUDP*)bufRx;
+    if (!cabeceraValida(*cab)) continue;
+
+    if (cab->tipo == UDP_CONSULTA && n == sizeof(TramaConsultaUDP)) {
+      atenderConsulta(*(const TramaConsultaUDP*)bufRx, origen);
+    }
+    else if (cab->tipo == UDP_COMANDO && n == sizeof(TramaComandoUDP)) {
+      atenderComando(*(const TramaComandoUDP*)bufRx, origen);
+    }
+  }
+
+  avisarCambios();
+}
+
+#else
+
+// =================================================================================
+// SIN CLAVE CONFIGURADA
+// =================================================================================
+void ProtocoloUDP_begin() {}
+void ProtocoloUDP_loop() {}
+
+#endif
@@ -0,0 +1,106 @@
+#pragma once
+
+// =================================================================================
+// PROTOCOLO UDP – ESTADO Y COMANDOS PARA INTEGRACIONES (DOMÓTICA)
+// =================================================================================
+// Alternativa liviana a consultar la WebUI por HTTP. Tramas binarias de tamaño
+// fijo, little-endian, autenticadas con HMAC-SHA256 truncado a 16 bytes
+// (clave UDP_CLAVE en secrets.h). Sin heap: socket lwIP y buffers estáticos.
+// Sin UDP_CLAVE las funciones quedan vacías.
+//
+//   Puerto UDP_PUERTO (unicast):
+//     CONSULTA → responde ESTADO
+//     COMANDO  → responde ACK (y ejecuta si corresponde)
+//
+//   Grupo UDP_MULTICAST_IP:UDP_MULTICAST_PUERTO:
+//     ESTADO enviado en cada cambio de portón / seguridad / flags
+//
+// Comandos idempotentes:
+//   - 'sesion' debe coincidir con la del equipo (cambia en cada arranque;
+//     se obtiene de cualquier trama ESTADO). Evita repetir comandos viejos.
+//   - 'secuencia' debe crecer. La misma secuencia repetida responde
+//     ACK_DUPLICADO sin volver a ejecutar (reintentos seguros).
+//
+// ESTADO y ACK repiten la 'secuencia' de la trama que responden; los avisos
+// multicast usan un contador propio del equipo.
+//
+// Tramas con HMAC inválido se descartan sin respuesta.
+// =================================================================================
+
+// Solo tipos estándar: el cliente de tools/ incluye este mismo header
+#include <stdint.h>
+#include <stddef.h>
+
+#define UDP_VERSION_PROTOCOLO 1
+#define UDP_LARGO_MAC         16
+
+// ===================== TIPOS DE TRAMA =====================
+enum TipoTramaUDP : uint8_t {
+  UDP_CONSULTA = 1,
+  UDP_ESTADO   = 2,
+  UDP_COMANDO  = 3,
+  UDP_ACK      = 4
+};
+
+enum ComandoUDP : uint8_t {
+  UDP_CMD_PULSO = 1
+};
+
+enum ResultadoUDP : uint8_t {
+  UDP_ACK_ACEPTADO  = 0,
+  UDP_ACK_DUPLICADO = 1,   // Ya ejecutado: no se repite
+  UDP_ACK_VIEJO     = 2,   // Secuencia menor a la última
+  UDP_ACK_SESION    = 3,   // Sesión distinta (equipo reiniciado)
+  UDP_ACK_DESCONOCIDO = 4  // Comando no soportado
+};
+
+// ===================== TRAMAS =============================
+struct __attribute__((packed)) CabeceraUDP {
+  uint8_t  magia[2];       // 'P', 'U'
+  uint8_t  version;
+  uint8_t  tipo;           // TipoTramaUDP
+  uint32_t sesion;
+  uint32_t secuencia;
+};
+
+// Bits de TramaEstadoUDP::flags
+#define UDP_FLAG_PANICO        0x01
+#define UDP_FLAG_EMERGENCIA    0x02
+#define UDP_FLAG_MANTENIMIENTO 0x04
+#define UDP_FLAG_BARRERA       0x08
+
+struct __attribute__((packed)) TramaConsultaUDP {
+  CabeceraUDP cab;
+  uint8_t mac[UDP_LARGO_MAC];
+};
+
+struct __attribute__((packed)) TramaEstadoUDP {
+  CabeceraUDP cab;
+  uint8_t  estadoPorton;     // Mismo código que estadoPortonUI
+  uint8_t  estadoSeguridad;  // Mismo código que estadoSeguridadUI
+  uint8_t  flags;
+  uint8_t  reservado;
+  char     ultimoUsuario[20];
+  uint32_t ciclos;
+  uint32_t alarmas;
+  uint32_t uptime;           // segundos
+  uint8_t  mac[UDP_LARGO_MAC];
+};
+
+struct __attribute__((packed)) TramaComandoUDP {
+  CabeceraUDP cab;
+  uint8_t comando;           // ComandoUDP
+  uint8_t reservado[3];
+  uint8_t mac[UDP_LARGO_MAC];
+};
+
+struct __attribute__((packed)) TramaAckUDP {
+  CabeceraUDP cab;           // 'secuencia' = la del comando respondido
+  uint8_t resultado;         // ResultadoUDP
+  uint8_t reservado[3];
+  uint8_t mac[UDP_LARGO_MAC];
+};
+
+// ===================== API ================================
+void ProtocoloUDP_begin();
+void ProtocoloUDP_loop();    // Abre/cierra el socket según WiFi y atiende tramas
@@ -0,0 +1,409 @@
+#include "PuenteMQTT.h"
+
+#include "secrets.h"
+
+#ifdef MQTT_HOST
+
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include <esp_system.h>
+
+// =================================================================================
+// 1. CONFIGURACIÓN
+// =================================================================================
+#ifndef MQTT_PUERTO
+#define MQTT_PUERTO 1883
+#endif
+
+#ifndef MQTT_USUARIO
+#define MQTT_USUARIO nullptr
+#endif
+
+#ifndef MQTT_CLAVE
+#define MQTT_CLAVE nullptr
+#endif
+
+#ifndef MQTT_ID
+#define MQTT_ID "porton"
+#endif
+
+#define MQTT_CAPACIDAD_COLA     16
+#define MQTT_EVENTOS_POR_LOTE   8
+#define MQTT_PERIODO_LOTE_MS    250      // Espera máxima para juntar eventos
+#define MQTT_REINTENTO_MS       5000
+#define MQTT_PERIODO_TAREA_MS   20
+#define MQTT_LARGO_PAYLOAD      2048
+#define MQTT_LARGO_COMANDO      40       // "PULSO <sesion> <secuencia>"
+
+// =================================================================================
+// 2. ESTADO DEL SISTEMA (main.cpp)
+// =================================================================================
+extern int  estadoPortonUI;
+extern int  estadoSeguridadUI;
+extern char ultimoUsuario[20];
+extern bool solicitudPulso;
+
+void registrarEvento(String msg, String userForzado);
+
+// =================================================================================
+// 3. VARIABLES
+// =================================================================================
+struct EventoMQTT {
+  uint32_t t;              // millis() del evento
+  char     texto[56];
+  char     usuario[20];
+};
+
+struct EstadoMQTT {
+  int  porton;
+  int  seguridad;
+  char usuario[20];
+};
+
+// ---- Compartidas loop() ↔ tarea (protegidas por mux) ----
+static portMUX_TYPE muxMQTT = portMUX_INITIALIZER_UNLOCKED;
+
+static EventoMQTT cola[MQTT_CAPACIDAD_COLA];
+static uint8_t    colaInicio   = 0;
+static uint8_t    colaCantidad = 0;
+static uint32_t   descartadosPendientes = 0;
+
+static EstadoMQTT estadoPendiente;
+static bool       estadoSucio = false;
+
+static volatile bool comandoPulso = false;
+
+static volatile uint32_t totalPublicados  = 0;
+static volatile uint32_t totalDescartados = 0;
+
+// ---- Solo de la tarea ----
+static WiFiClient   clienteWiFi;
+static PubSubClient mqtt(clienteWiFi);
+
+static char topicEstado[48];
+static char topicEventos[48];
+static char topicConexion[48];
+static char topicCmd[48];
+static char topicAck[48];
+
+// Comandos: sesión por arranque + secuencia creciente (igual que el protocolo UDP)
+static uint32_t    sesion          = 0;
+static uint32_t    ultimaSecuencia = 0;
+static bool        ackPendiente    = false;
+static uint32_t    ackSecuencia    = 0;
+static const char* ackResultado    = "";
+
+static EventoMQTT lote[MQTT_EVENTOS_POR_LOTE];   // Lote en vuelo (se reintenta)
+static uint8_t    loteCantidad    = 0;
+static uint32_t   loteDescartados = 0;
+
+static char payload[MQTT_LARGO_PAYLOAD];
+
+// =================================================================================
+// 4. HELPERS
+// =================================================================================
+
+// Copia texto a JSON escapando comillas y barras
+static size_t escribirTextoJSON(char* dst, size_t libre, const char* src) {
+  size_t n = 0;
+  for (; *src && n + 2 < libre; src++) {
+    if (*src == '"' || *src == '\\') dst[n++] = '\\';
+    dst[n++] = *src;
+  }
+  dst[n] = '\0';
+  return n;
+}
+
+static bool publicar(const char* topic, const char* texto, bool retenido) {
+  if (!mqtt.publish(topic, texto, retenido)) return false;
+  totalPublicados++;
+  return true;
+}
+
+// Corre dentro de mqtt.loop() (tarea). El ack se publica después: el buffer de
+// PubSubClient todavía contiene este mensaje
+static void alRecibir(char* topic, byte* datos, unsigned int largo) {
+
+  if (strcmp(topic, topicCmd) != 0) return;
+
+  // Vacío: el borrado del retenido que hace conectar()
+  if (largo == 0) return;
+
+  char texto[MQTT_LARGO_COMANDO];
+  char nombre[8];
+  unsigned long ses = 0, secuencia = 0;
+  int campos = 0;
+
+  if (largo < sizeof(texto)) {
+    memcpy(texto, datos, largo);
+    texto[largo] = '\0';
+    campos = sscanf(texto, "%7s %lx %lu", nombre, &ses, &secuencia);
+  }
+
+  const char* resultado;
+
+  if (campos != 3)                          resultado = "invalido";
+  else if (ses != sesion)                   resultado = "sesion";
+  else if (secuencia == ultimaSecuencia)    resultado = "duplicado";
+  else if (secuencia <  ultimaSecuencia)    resultado = "viejo";
+  else if (strcmp(nombre, "PULSO") != 0)    resultado = "desconocido";
+  else {
+    ultimaSecuencia = secuencia;
+    comandoPulso = true;
+    resultado = "aceptado";
+
+    // La última secuencia aceptada viaja en el estado
+    portENTER_CRITICAL(&muxMQTT);
+    estadoSucio = true;
+    portEXIT_CRITICAL(&muxMQTT);
+  }
+
+  ackPendiente = true;
+  ackSecuencia = (campos == 3) ? secuencia : 0;
+  ackResultado = resultado;
+}
+
+// =================================================================================
+// 5. TAREA DE RED (core 0)
+// =================================================================================
+static bool conectar() {
+
+  if (!mqtt.connect(MQTT_ID, MQTT_USUARIO, MQTT_CLAVE,
+                    topicConexion, 1, true, "offline")) {
+    return false;
+  }
+
+  publicar(topicConexion, "online", true);
+
+  // Un comando retenido en el broker se entregaría en cada reconexión: se borra
+  // antes de suscribirse. Los de arranques anteriores además traen otra sesión
+  mqtt.publish(topicCmd, "", true);
+  mqtt.subscribe(topicCmd);
+
+  // Puesta al día: estado completo; los eventos encolados salen en lotes
+  portENTER_CRITICAL(&muxMQTT);
+  estadoSucio = true;
+  portEXIT_CRITICAL(&muxMQTT);
+
+  return true;
+}
+
+static void enviarEstado() {
+
+  EstadoMQTT e;
+  bool sucio;
+
+  portENTER_CRITICAL(&muxMQTT);
+  sucio = estadoSucio;
+  e = estadoPendiente;
+  estadoSucio = false;
+  portEXIT_CRITICAL(&muxMQTT);
+
+  if (!sucio) return;
+
+  int n = snprintf(payload, sizeof(payload),
+                   "{\"porton\":%d,\"seguridad\":%d,\"sesion\":\"%08lx\",\"secuencia\":%lu,"
+                   "\"usuario\":\"",
+                   e.porton, e.seguridad, (unsigned long)sesion, (unsigned long)ultimaSecuencia);
+  n += escribirTextoJSON(payload + n, sizeof(payload) - n - 2, e.usuario);
+  strcpy(payload + n, "\"}");
+
+  if (!publicar(topicEstado, payload, true)) {
+    // Se reintenta en la próxima vuelta
+    portENTER_CRITICAL(&muxMQTT);
+    estadoSucio = true;
+    portEXIT_CRITICAL(&muxMQTT);
+  }
+}
+
+static void enviarAck() {
+
+  if (!ackPendiente) return;
+  ackPendiente = false;
+
+  // Sin reintento: el cliente reenvía la misma secuencia y recibe "duplicado"
+  snprintf(payload, sizeof(payload), "{\"secuencia\":%lu,\"resultado\":\"%s\"}",
+           (unsigned long)ackSecuencia, ackResultado);
+  publicar(topicAck, payload, false);
+}
+
+static void enviarEventos() {
+
+  static unsigned long tPrimerEvento = 0;
+
+  // ---- Completar el lote desde la cola ----
+  portENTER_CRITICAL(&muxMQTT);
+  while (loteCantidad < MQTT_EVENTOS_POR_LOTE && colaCantidad > 0) {
+    lote[loteCantidad++] = cola[colaInicio];
+    colaInicio = (colaInicio + 1) % MQTT_CAPACIDAD_COLA;
+    colaCantidad--;
+  }
+  loteDescartados += descartadosPendientes;
+  descartadosPendientes = 0;
+  portEXIT_CRITICAL(&muxMQTT);
+
+  if (loteCantidad == 0 && loteDescartados == 0) {
+    tPrimerEvento = 0;
+    return;
+  }
+
+  // ---- Juntar eventos: lote lleno o tiempo cumplido ----
+  if (tPrimerEvento == 0) tPrimerEvento = millis();
+  if (loteCantidad < MQTT_EVENTOS_POR_LOTE &&
+      millis() - tPrimerEvento < MQTT_PERIODO_LOTE_MS) {
+    return;
+  }
+
+  unsigned long ahora = millis();
+  size_t n = snprintf(payload, sizeof(payload), "{\"descartados\":%lu,\"eventos\":[",
+                      (unsigned long)loteDescartados);
+
+  // Peor caso por evento (texto y usuario escapados) + campos fijos
+  const size_t largoMaxEvento = 2 * (sizeof(lote[0].texto) + sizeof(lote[0].usuario)) + 64;
+
+  uint8_t enviados = 0;
+  for (uint8_t i = 0; i < loteCantidad && n + largoMaxEvento + 4 < sizeof(payload); i++) {
+    n += snprintf(payload + n, sizeof(payload) - n, "%s{\"hace_ms\":%lu,\"msg\":\"",
+                  i ? "," : "", (unsigned long)(ahora - lote[i].t));
+    n += escribirTextoJSON(payload + n, sizeof(payload) - n, lote[i].texto);
+    n += snprintf(payload + n, sizeof(payload) - n, "\",\"usuario\":\"");
+    n += escribirTextoJSON(payload + n, sizeof(payload) - n, lote[i].usuario);
+    n += snprintf(payload + n, sizeof(payload) - n, "\"}");
+    enviados++;
+  }
+  snprintf(payload + n, sizeof(payload) - n, "]}");
+
+  // Si el broker no acepta, el lote queda y se reintenta (la cola sigue acotada)
+  if (!publicar(topicEventos, payload, false)) return;
+
+  // Lo que no entró en el payload queda para el próximo lote
+  loteCantidad -= enviados;
+  memmove(lote, lote + enviados, loteCantidad * sizeof(EventoMQTT));
+  loteDescartados = 0;
+  tPrimerEvento   = loteCantidad ? millis() - MQTT_PERIODO_LOTE_MS : 0;
+}
+
+// Una vuelta de la tarea (separada para poder ejecutarla en los tests host)
+static void cicloMQTT() {
+
+  static unsigned long tUltimoIntento = 0;
+
+  if (WiFi.status() != WL_CONNECTED) return;
+
+  if (!mqtt.connected()) {
+    if (tUltimoIntento != 0 && millis() - tUltimoIntento < MQTT_REINTENTO_MS) return;
+    tUltimoIntento = millis();
+    if (!conectar()) return;
+  }
+
+  mqtt.loop();
+  enviarAck();
+  enviarEstado();
+  enviarEventos();
+}
+
+static void tareaMQTT(void*) {
+  for (;;) {
+    vTaskDelay(pdMS_TO_TICKS(MQTT_PERIODO_TAREA_MS));
+    cicloMQTT();
+  }
+}
+
+// =================================================================================
+// 6. API
+// =================================================================================
+void PuenteMQTT_begin() {
+
+  snprintf(topicEstado,   sizeof(topicEstado),   "portones/%s/estado",   MQTT_ID);
+  snprintf(topicEventos,  sizeof(topicEventos),  "portones/%s/eventos",  MQTT_ID);
+  snprintf(topicConexion, sizeof(topicConexion), "portones/%s/conexion", MQTT_ID);
+  snprintf(topicCmd,      sizeof(topicCmd),      "portones/%s/cmd",      MQTT_ID);
+  snprintf(topicAck,      sizeof(topicAck),      "portones/%s/cmd/ack",  MQTT_ID);
+
+  sesion = esp_random();
+
+  // Única reserva de memoria del módulo, al arrancar
+  mqtt.setBufferSize(MQTT_LARGO_PAYLOAD + 64);
+  mqtt.setServer(MQTT_HOST, MQTT_PUERTO);
+  mqtt.setCallback(alRecibir);
+  mqtt.setSocketTimeout(2);
+
+  estadoPendiente.porton    = -1;
+  estadoPendiente.seguridad = -1;
+  estadoPendiente.usuario[0] = '\0';
+
+  xTaskCreatePinnedToCore(tareaMQTT, "mqtt", 4096, nullptr, 1, nullptr, 0);
+}
+
+void PuenteMQTT_loop() {
+
+  // --------------------------------------------------
+  // Estado: solo se marca si cambió (coalescencia)
+  // --------------------------------------------------
+  if (estadoPortonUI    != estadoPendiente.porton ||
+      estadoSeguridadUI != estadoPendiente.seguridad ||
+      strcmp(ultimoUsuario, estadoPendiente.usuario) != 0) {
+
+    portENTER_CRITICAL(&muxMQTT);
+    estadoPendiente.porton    = estadoPortonUI;
+    estadoPendiente.seguridad = estadoSeguridadUI;
+    strncpy(estadoPendiente.usuario, ultimoUsuario, sizeof(estadoPendiente.usuario) - 1);
+    estadoPendiente.usuario[sizeof(estadoPendiente.usuario) - 1] = '\0';
+    estadoSucio = true;
+    portEXIT_CRITICAL(&muxMQTT);
+  }
+
+  // --------------------------------------------------
+  // Comando remoto
+  // --------------------------------------------------
+  if (comandoPulso) {
+    comandoPulso = false;
+    strcpy(ultimoUsuario, "MQTT");
+    solicitudPulso = true;
+    registrarEvento("Comando MQTT", "MQTT");
+  }
+}
+
+void PuenteMQTT_publicarEvento(const char* msg, const char* usuario) {
+
+  portENTER_CRITICAL(&muxMQTT);
+
+  // Cola llena → se pierde el más viejo
+  if (colaCantidad == MQTT_CAPACIDAD_COLA) {
+    colaInicio = (colaInicio + 1) % MQTT_CAPACIDAD_COLA;
+    colaCantidad--;
+    descartadosPendientes++;
+    totalDescartados++;
+  }
+
+  EventoMQTT& e = cola[(colaInicio + colaCantidad) % MQTT_CAPACIDAD_COLA];
+  e.t = millis();
+  strncpy(e.texto, msg, sizeof(e.texto) - 1);
+  e.texto[sizeof(e.texto) - 1] = '\0';
+  strncpy(e.usuario, usuario, sizeof(e.usuario) - 1);
+  e.usuario[sizeof(e.usuario) - 1] = '\0';
+  colaCantidad++;
+
+  portEXIT_CRITICAL(&muxMQTT);
+}
+
+uint32_t PuenteMQTT_mensajesPublicados() {
+  return totalPublicados;
+}
+
+uint32_t PuenteMQTT_eventosDescartados() {
+  return totalDescartados;
+}
+
+#else
+
+// =================================================================================
+// SIN BROKER CONFIGURADO
+// =================================================================================
+void PuenteMQTT_begin() {}
+void PuenteMQTT_loop() {}
+void PuenteMQTT_publicarEvento(const char*, const char*) {}
+uint32_t PuenteMQTT_mensajesPublicados() { return 0; }
+uint32_t PuenteMQTT_eventosDescartados() { return 0; }
+
+#endif
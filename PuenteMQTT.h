@@ -0,0 +1,39 @@
+#pragma once
+
+// =================================================================================
+// PUENTE MQTT – TELEMETRÍA Y COMANDOS PARA GESTIÓN CENTRALIZADA
+// =================================================================================
+// Se habilita definiendo MQTT_HOST en secrets.h (opcionales: MQTT_PUERTO,
+// MQTT_USUARIO, MQTT_CLAVE, MQTT_ID). Sin MQTT_HOST las funciones quedan vacías.
+//
+// Toda la red corre en una tarea propia (core 0): el loop() solo copia datos a
+// memoria fija y nunca espera al broker.
+//
+//   portones/<id>/estado    JSON retenido, se COALESCE (solo el último cuenta)
+//   portones/<id>/eventos   Lotes de hasta MQTT_EVENTOS_POR_LOTE eventos
+//   portones/<id>/conexion  "online" / "offline" (LWT), retenido
+//   portones/<id>/cmd       Entrada: "PULSO <sesion> <secuencia>"
+//   portones/<id>/cmd/ack   {"secuencia":N,"resultado":"..."}
+//
+// Comandos: igual que el protocolo UDP. La sesión (hex, nueva en cada arranque)
+// y la última secuencia aceptada se publican en el estado; solo se acepta una
+// secuencia mayor. Resultados: aceptado, duplicado, viejo, sesion, desconocido,
+// invalido. Al conectar se borra cualquier comando retenido en el broker, así
+// una reconexión no repite un pulso.
+//
+// Contrapresión: la cola de eventos es de tamaño fijo. Si se llena (broker caído
+// o lento) se descarta el más viejo y se informa la cantidad perdida en el
+// próximo lote. Al reconectar se republica el estado y se vacía lo encolado.
+// =================================================================================
+
+#include <Arduino.h>
+
+void PuenteMQTT_begin();
+void PuenteMQTT_loop();   // Coalesce estado y toma comandos recibidos
+
+// Encola un evento (no bloquea; si la cola está llena descarta el más viejo)
+void PuenteMQTT_publicarEvento(const char* msg, const char* usuario);
+
+// Métricas
+uint32_t PuenteMQTT_mensajesPublicados();
+uint32_t PuenteMQTT_eventosDescartados();
@@ -0,0 +1,451 @@
+#include "Telemetria.h"
+
+#include <Preferences.h>
+#include <time.h>
+
+// =================================================================================
+// 1. CONFIGURACIÓN
+// =================================================================================
+#define TELEM_CAP_MINUTOS   60
+#define TELEM_CAP_HORAS     48
+#define TELEM_CAP_DIAS      31
+
+#define TELEM_MS_MINUTO     60000UL
+#define TELEM_MIN_POR_HORA  60
+#define TELEM_HORAS_POR_DIA 24
+
+#define TELEM_VERSION       3
+#define TELEM_NVS_NAMESPACE "telemetria"
+#define TELEM_NVS_CLAVE     "rrd"
+
+#define TELEM_VERSION_TOTALES   1
+#define TELEM_NVS_CLAVE_TOTALES "totales"
+#define TELEM_MS_TOTALES        30000UL   // Mínimo entre checkpoints de totales
+
+// =================================================================================
+// 2. ESTRUCTURAS INTERNAS
+// =================================================================================
+
+// Acumulador del período en curso (todavía no consolidado)
+struct AcumuladorTelemetria {
+  uint32_t ciclos;
+  uint32_t alarmas;
+  uint32_t viajeMin;
+  uint32_t viajeMax;
+  uint32_t viajeSuma;
+  uint32_t viajeN;
+  uint32_t loopMin;
+  uint32_t loopMax;
+  uint64_t loopSuma;
+  uint32_t loopN;
+};
+
+// Archivo circular de capacidad fija
+struct ArchivoTelemetria {
+  uint16_t cabeza;      // Próxima posición a escribir
+  uint16_t cantidad;    // Muestras válidas (<= capacidad)
+};
+
+// Totales en un blob chico aparte: se guardan al cambiar, sin reescribir el RRD
+struct TotalesTelemetria {
+  uint8_t  version;
+  uint8_t  reservado[3];
+  uint32_t ciclos;
+  uint32_t alarmas;
+};
+
+// Todo el estado persistente en un único bloque (un solo blob en flash)
+struct EstadoTelemetria {
+  uint8_t  version;
+  uint8_t  minutosEnHora;
+  uint8_t  horasEnDia;
+  uint8_t  reservado;
+
+  uint32_t totalCiclos;     // Contadores históricos (no se reinician)
+  uint32_t totalAlarmas;
+
+  ArchivoTelemetria archMinutos;
+  ArchivoTelemetria archHoras;
+  ArchivoTelemetria archDias;
+
+  AcumuladorTelemetria accHora;
+  AcumuladorTelemetria accDia;
+
+  MuestraTelemetria minutos[TELEM_CAP_MINUTOS];
+  MuestraTelemetria horas[TELEM_CAP_HORAS];
+  MuestraTelemetria dias[TELEM_CAP_DIAS];
+};
+
+// =================================================================================
+// 3. VARIABLES
+// =================================================================================
+static EstadoTelemetria     telem;
+static AcumuladorTelemetria accMinuto;
+static unsigned long        tMinuto = 0;
+
+static bool          totalesSucios = false;   // Cambiaron desde el último checkpoint
+static unsigned long tTotales      = 0;       // millis() del último checkpoint
+
+// ---- Checkpoints: el loop() copia, la tarea (core 0) escribe en flash ----
+static EstadoTelemetria  copiaRRD;
+static TotalesTelemetria copiaTotales;
+static volatile bool     rrdPendiente      = false;   // Copia lista, falta escribir
+static volatile bool     totalesPendientes = false;
+static bool              rrdSolicitado     = false;   // Cierre de hora con la tarea ocupada
+static TaskHandle_t      tareaGuardado     = nullptr;
+
+// =================================================================================
+// 4. HELPERS
+// =================================================================================
+static void limpiarAcumulador(AcumuladorTelemetria& a) {
+  memset(&a, 0, sizeof(a));
+  a.viajeMin = UINT32_MAX;
+  a.loopMin  = UINT32_MAX;
+}
+
+static uint16_t saturar16(uint32_t v) {
+  return (v > 0xFFFF) ? 0xFFFF : (uint16_t)v;
+}
+
+// Suma un período cerrado dentro del período mayor (consolidación exacta)
+static void combinar(AcumuladorTelemetria& destino, const AcumuladorTelemetria& origen) {
+  destino.ciclos  += origen.ciclos;
+  destino.alarmas += origen.alarmas;
+
+  if (origen.viajeN > 0) {
+    if (origen.viajeMin < destino.viajeMin) destino.viajeMin = origen.viajeMin;
+    if (origen.viajeMax > destino.viajeMax) destino.viajeMax = origen.viajeMax;
+    destino.viajeSuma += origen.viajeSuma;
+    destino.viajeN    += origen.viajeN;
+  }
+
+  if (origen.loopN > 0) {
+    if (origen.loopMin < destino.loopMin) destino.loopMin = origen.loopMin;
+    if (origen.loopMax > destino.loopMax) destino.loopMax = origen.loopMax;
+
+    destino.loopSuma += origen.loopSuma;
+    destino.loopN    += origen.loopN;
+  }
+}
+
+static MuestraTelemetria consolidar(const AcumuladorTelemetria& a) {
+
+  MuestraTelemetria m;
+  time_t ahora = time(nullptr);
+  m.marca   = (ahora > 1600000000) ? (uint32_t)ahora : 0;
+  m.ciclos  = saturar16(a.ciclos);
+  m.alarmas = saturar16(a.alarmas);
+
+  if (a.viajeN > 0) {
+    m.viajeMin  = saturar16(a.viajeMin);
+    m.viajeProm = saturar16(a.viajeSuma / a.viajeN);
+    m.viajeMax  = saturar16(a.viajeMax);
+  } else {
+    m.viajeMin = m.viajeProm = m.viajeMax = 0;
+  }
+
+  if (a.loopN > 0) {
+    m.loopMin  = a.loopMin;
+    m.loopProm = (uint32_t)(a.loopSuma / a.loopN);
+    m.loopMax  = a.loopMax;
+  } else {
+    m.loopMin = m.loopProm = m.loopMax = 0;
+  }
+
+  return m;
+}
+
+static void agregar(ArchivoTelemetria& arch, MuestraTelemetria* buf,
+                    uint16_t capacidad, const MuestraTelemetria& m) {
+  buf[arch.cabeza] = m;
+  arch.cabeza = (arch.cabeza + 1) % capacidad;
+  if (arch.cantidad < capacidad) arch.cantidad++;
+}
+
+static void armarTotales(TotalesTelemetria& t) {
+  memset(&t, 0, sizeof(t));
+  t.version = TELEM_VERSION_TOTALES;
+  t.ciclos  = telem.totalCiclos;
+  t.alarmas = telem.totalAlarmas;
+}
+
+static void seleccionar(ResolucionTelemetria res, const ArchivoTelemetria*& arch,
+                        const MuestraTelemetria*& buf, uint16_t& capacidad) {
+  switch (res) {
+    case TELEM_HORA:
+      arch = &telem.archHoras;   buf = telem.horas;   capacidad = TELEM_CAP_HORAS;   break;
+    case TELEM_DIA:
+      arch = &telem.archDias;    buf = telem.dias;    capacidad = TELEM_CAP_DIAS;    break;
+    default:
+      arch = &telem.archMinutos; buf = telem.minutos; capacidad = TELEM_CAP_MINUTOS; break;
+  }
+}
+
+// =================================================================================
+// 5. CHECKPOINTS EN FLASH
+// =================================================================================
+static void escribirRRD(const EstadoTelemetria& e) {
+  Preferences prefs;
+  if (!prefs.begin(TELEM_NVS_NAMESPACE, false)) return;
+  prefs.putBytes(TELEM_NVS_CLAVE, &e, sizeof(e));
+  prefs.end();
+}
+
+static void escribirTotales(const TotalesTelemetria& t) {
+  Preferences prefs;
+  if (!prefs.begin(TELEM_NVS_NAMESPACE, false)) return;
+  prefs.putBytes(TELEM_NVS_CLAVE_TOTALES, &t, sizeof(t));
+  prefs.end();
+}
+
+// Escribe las copias pendientes (tarea)
+static void guardarPendientes() {
+  if (rrdPendiente) {
+    escribirRRD(copiaRRD);
+    rrdPendiente = false;
+  }
+  if (totalesPendientes) {
+    escribirTotales(copiaTotales);
+    totalesPendientes = false;
+  }
+}
+
+static void tareaTelemetria(void*) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    guardarPendientes();
+  }
+}
+
+static void despertarTarea() {
+  if (tareaGuardado) xTaskNotifyGive(tareaGuardado);
+  else               guardarPendientes();    // Sin tarea: en el momento
+}
+
+// Lado loop(): solo copia a memoria fija. Si la tarea sigue con la copia
+// anterior no se pisa; se reintenta en la próxima vuelta
+static void pedirRRD() {
+  if (rrdPendiente) {
+    rrdSolicitado = true;
+    return;
+  }
+  memcpy(&copiaRRD, &telem, sizeof(telem));
+  rrdSolicitado = false;
+  rrdPendiente  = true;
+  despertarTarea();
+}
+
+static void pedirTotales() {
+  if (totalesPendientes) return;
+  armarTotales(copiaTotales);
+  totalesSucios     = false;
+  tTotales          = millis();
+  totalesPendientes = true;
+  despertarTarea();
+}
+
+// =================================================================================
+// 6. CIERRE DE PERÍODOS
+// =================================================================================
+static void cerrarMinuto() {
+
+  agregar(telem.archMinutos, telem.minutos, TELEM_CAP_MINUTOS, consolidar(accMinuto));
+  combinar(telem.accHora, accMinuto);
+  limpiarAcumulador(accMinuto);
+
+  if (++telem.minutosEnHora < TELEM_MIN_POR_HORA) return;
+  telem.minutosEnHora = 0;
+
+  // ---- Cierre de hora ----
+  agregar(telem.archHoras, telem.horas, TELEM_CAP_HORAS, consolidar(telem.accHora));
+  combinar(telem.accDia, telem.accHora);
+  limpiarAcumulador(telem.accHora);
+
+  if (++telem.horasEnDia >= TELEM_HORAS_POR_DIA) {
+    telem.horasEnDia = 0;
+
+    // ---- Cierre de día ----
+    agregar(telem.archDias, telem.dias, TELEM_CAP_DIAS, consolidar(telem.accDia));
+    limpiarAcumulador(telem.accDia);
+  }
+
+  // Una escritura por hora: desgaste de flash despreciable
+  pedirRRD();
+}
+
+// =================================================================================
+// 7. CICLO DE VIDA
+// =================================================================================
+void Telemetria_begin() {
+
+  limpiarAcumulador(accMinuto);
+  tMinuto = millis();
+
+  // El primer cambio después de arrancar se guarda enseguida
+  totalesSucios = false;
+  tTotales = tMinuto - TELEM_MS_TOTALES;
+
+  Preferences prefs;
+  bool restaurado = false;
+  TotalesTelemetria totales;
+  memset(&totales, 0, sizeof(totales));
+
+  if (prefs.begin(TELEM_NVS_NAMESPACE, true)) {
+    if (prefs.getBytesLength(TELEM_NVS_CLAVE) == sizeof(telem)) {
+      prefs.getBytes(TELEM_NVS_CLAVE, &telem, sizeof(telem));
+      restaurado = (telem.version == TELEM_VERSION);
+    }
+    if (prefs.getBytesLength(TELEM_NVS_CLAVE_TOTALES) == sizeof(totales)) {
+      prefs.getBytes(TELEM_NVS_CLAVE_TOTALES, &totales, sizeof(totales));
+    }
+    prefs.end();
+  }
+
+  if (!restaurado) {
+    memset(&telem, 0, sizeof(telem));
+    telem.version = TELEM_VERSION;
+    limpiarAcumulador(telem.accHora);
+    limpiarAcumulador(telem.accDia);
+  }
+
+  // Los totales del RRD tienen hasta una hora de atraso: vale el más alto
+  if (totales.version == TELEM_VERSION_TOTALES) {
+    if (totales.ciclos  > telem.totalCiclos)  telem.totalCiclos  = totales.ciclos;
+    if (totales.alarmas > telem.totalAlarmas) telem.totalAlarmas = totales.alarmas;
+  }
+
+  // Baja prioridad en el core 0: la escritura en flash no corre en el loop()
+  if (!tareaGuardado) {
+    xTaskCreatePinnedToCore(tareaTelemetria, "telemetria", 4096, nullptr, 1,
+                            &tareaGuardado, 0);
+  }
+}
+
+void Telemetria_loop() {
+  unsigned long ahora = millis();
+
+  if (rrdSolicitado) pedirRRD();
+
+  // Checkpoint de totales: al cambiar, como mucho uno cada TELEM_MS_TOTALES
+  if (totalesSucios && ahora - tTotales >= TELEM_MS_TOTALES) pedirTotales();
+
+  if (ahora - tMinuto < TELEM_MS_MINUTO) return;
+
+  tMinuto += TELEM_MS_MINUTO;
+  cerrarMinuto();
+}
+
+// Escritura directa: para usar fuera del ciclo de control (ej. antes de reiniciar)
+void Telemetria_guardar() {
+
+  escribirRRD(telem);
+
+  if (totalesSucios) {
+    TotalesTelemetria t;
+    armarTotales(t);
+    escribirTotales(t);
+    totalesSucios = false;
+    tTotales = millis();
+  }
+}
+
+// =================================================================================
+// 8. REGISTRO
+// =================================================================================
+void Telemetria_registrarCiclo() {
+  accMinuto.ciclos++;
+  telem.totalCiclos++;
+  totalesSucios = true;
+}
+
+void Telemetria_registrarAlarma() {
+  accMinuto.alarmas++;
+  telem.totalAlarmas++;
+  totalesSucios = true;
+}
+
+void Telemetria_registrarViaje(unsigned long duracionMs) {
+  uint32_t decimas = duracionMs / 100;
+  if (decimas < accMinuto.viajeMin) accMinuto.viajeMin = decimas;
+  if (decimas > accMinuto.viajeMax) accMinuto.viajeMax = decimas;
+  accMinuto.viajeSuma += decimas;
+  accMinuto.viajeN++;
+}
+
+void Telemetria_registrarLoop(unsigned long duracionUs) {
+  if (duracionUs < accMinuto.loopMin) accMinuto.loopMin = duracionUs;
+  if (duracionUs > accMinuto.loopMax) accMinuto.loopMax = duracionUs;
+  accMinuto.loopSuma += duracionUs;
+  accMinuto.loopN++;
+}
+
+// =================================================================================
+// 9. CONSULTA
+// =================================================================================
+uint32_t Telemetria_totalCiclos() {
+  return telem.totalCiclos;
+}
+
+uint32_t Telemetria_totalAlarmas() {
+  return telem.totalAlarmas;
+}
+
+size_t Telemetria_exportarCSV(Print& out, ResolucionTelemetria res, uint16_t maxMuestras) {
+
+  const ArchivoTelemetria* arch;
+  const MuestraTelemetria* buf;
+  uint16_t capacidad;
+  seleccionar(res, arch, buf, capacidad);
+
+  uint16_t cantidad = arch->cantidad;
+  if (maxMuestras > 0 && maxMuestras < cantidad) cantidad = maxMuestras;
+
+  size_t escritos = out.print(
+    "marca,ciclos,alarmas,viaje_min,viaje_prom,viaje_max,loop_min,loop_prom,loop_max\n");
+
+  char linea[96];
+  uint16_t inicio = (arch->cabeza + capacidad - cantidad) % capacidad;
+
+  for (uint16_t i = 0; i < cantidad; i++) {
+    const MuestraTelemetria& m = buf[(inicio + i) % capacidad];
+    int n = snprintf(linea, sizeof(linea), "%lu,%u,%u,%u,%u,%u,%lu,%lu,%lu\n",
+                     (unsigned long)m.marca, m.ciclos, m.alarmas,
+                     m.viajeMin, m.viajeProm, m.viajeMax,
+                     (unsigned long)m.loopMin, (unsigned long)m.loopProm,
+                     (unsigned long)m.loopMax);
+    if (n > 0) escritos += out.write((const uint8_t*)linea, n);
+  }
+
+  return escritos;
+}
+
+size_t Telemetria_exportarBinario(Print& out, ResolucionTelemetria res, uint16_t maxMuestras) {
+
+  const ArchivoTelemetria* arch;
+  const MuestraTelemetria* buf;
+  uint16_t capacidad;
+  seleccionar(res, arch, buf, capacidad);
+
+  uint16_t cantidad = arch->cantidad;
+  if (maxMuestras > 0 && maxMuestras < cantidad) cantidad = maxMuestras;
+
+  uint8_t cabecera[8] = {
+    'P', 'T', 'E', 'L',
+    TELEM_VERSION,
+    (uint8_t)res,
+    (uint8_t)(cantidad & 0xFF),
+    (uint8_t)(cantidad >> 8)
+  };
+  size_t escritos = out.write(cabecera, sizeof(cabecera));
+
+  // Dos tramos contiguos como máximo (antes y después del fin del buffer)
+  uint16_t inicio = (arch->cabeza + capacidad - cantidad) % capacidad;
+  uint16_t tramo1 = min<uint16_t>(cantidad, capacidad - inicio);
+
+  escritos += out.write((const uint8_t*)&buf[inicio], tramo1 * sizeof(MuestraTelemetria));
+  if (cantidad > tramo1) {
+    escritos += out.write((const uint8_t*)&buf[0], (cantidad - tramo1) * sizeof(MuestraTelemetria));
+  }
+
+  return escritos;
+}
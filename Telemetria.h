@@ -0,0 +1,72 @@
+#pragma once
+
+// =================================================================================
+// TELEMETRÍA – HISTÓRICO CIRCULAR (ESTILO RRD)
+// =================================================================================
+// Guarda tendencias del portón con memoria FIJA, sin importar el tiempo encendido:
+//
+//   - Archivo MINUTO : 60 muestras de 1 min  (última hora)
+//   - Archivo HORA   : 48 muestras de 1 h    (últimos 2 días)
+//   - Archivo DÍA    : 31 muestras de 1 día  (último mes)
+//
+// Cada muestra consolida:
+//   - Ciclos completos y alarmas (suma del período)
+//   - Tiempo de viaje mín / prom / máx (décimas de segundo)
+//   - Tiempo de loop() mín / prom / máx (µs)
+//
+// Todo vive en RAM y se guarda en flash (Preferences) al cerrar cada hora.
+// Los totales históricos se guardan aparte al cambiar (como mucho cada 30 s):
+// tras un corte de energía pueden retroceder a lo sumo lo registrado en esos
+// últimos 30 s. Estos checkpoints los escribe una tarea de baja prioridad en el
+// core 0; el loop() solo copia el bloque a un buffer fijo.
+// La exportación escribe fila por fila sobre un Print (ej. server.client()),
+// así la WebUI no arma JSON grandes en el heap.
+// =================================================================================
+
+#include <Arduino.h>
+
+// ===================== RESOLUCIONES =======================
+enum ResolucionTelemetria {
+  TELEM_MINUTO,
+  TELEM_HORA,
+  TELEM_DIA
+};
+
+// ===================== MUESTRA CONSOLIDADA ================
+// Formato fijo (26 bytes, little-endian) usado también en la exportación binaria.
+struct __attribute__((packed)) MuestraTelemetria {
+  uint32_t marca;       // Hora de cierre (epoch s). 0 = sin hora NTP
+  uint16_t ciclos;
+  uint16_t alarmas;
+  uint16_t viajeMin;    // décimas de segundo
+  uint16_t viajeProm;
+  uint16_t viajeMax;
+  uint32_t loopMin;     // µs (32 bits: los loops lentos de WiFi / NVS superan 65 ms)
+  uint32_t loopProm;
+  uint32_t loopMax;
+};
+
+// ===================== CICLO DE VIDA ======================
+void Telemetria_begin();   // Restaura el último checkpoint de flash
+void Telemetria_loop();    // Cierra minutos / horas / días vencidos
+void Telemetria_guardar(); // Checkpoint forzado y bloqueante (ej. antes de reiniciar)
+
+// ===================== REGISTRO ===========================
+void Telemetria_registrarCiclo();
+void Telemetria_registrarAlarma();
+void Telemetria_registrarViaje(unsigned long duracionMs);
+void Telemetria_registrarLoop(unsigned long duracionUs);
+
+// ===================== CONSULTA ===========================
+// Totales desde la primera puesta en marcha (persisten en flash; ver arriba)
+uint32_t Telemetria_totalCiclos();
+uint32_t Telemetria_totalAlarmas();
+
+// Escriben desde la muestra más vieja a la más nueva (máx. 'maxMuestras',
+// 0 = todas). Devuelven la cantidad de bytes escritos.
+//
+// Binario: cabecera de 8 bytes
+//   "PTEL" | versión (1) | resolución (1) | cantidad (uint16)
+// seguida de 'cantidad' MuestraTelemetria.
+size_t Telemetria_exportarCSV(Print& out, ResolucionTelemetria res, uint16_t maxMuestras = 0);
+size_t Telemetria_exportarBinario(Print& out, ResolucionTelemetria res, uint16_t maxMuestras = 0);
@@ -13,6 +13,7 @@
 // === Config ===
 #include "Config.h"
 #include "Config_Hardware.h"
+#include "Config_Producto.h"
 #include "secrets.h"
 
 // === Servicios ===
@@ -20,6 +21,12 @@
 #include "WebUI.h"
 #include "Memoria.h"
 #include "RoleManager.h"
+#include "Telemetria.h"
+#include "ProtocoloUDP.h"
+#include "CorrienteMotor.h"
+#include "PuenteMQTT.h"
+#include "Patrones.h"
+#include "Diagnostico.h"
 
 // =================================================================================
 // 1. PROTOTIPOS
@@ -33,16 +40,20 @@ void gestionarPulso();
 // === Entradas / seguridad ===
 void procesarEntradasUsuario();
 void procesarBarrera();
+void procesarCorrienteMotor();
 void procesarSeguridad();
 
 // === Actuadores / UI ===
 void gestionarSirena();
 void gestionarSemaforo();
-void gestionarLedsPlaca();
 void gestionarLedConfig();
-void procesarBuzzer();
 void beep(uint8_t veces);
 
+// === Diagnóstico (solo DIAG_LOOP) ===
+#ifdef DIAG_LOOP
+void verificarInvariantes();
+#endif
+
 
 
 // =================================================================================
@@ -127,16 +138,8 @@ unsigned long tVisualObstaculo         = 0;
 unsigned long tFCAbiertoDesde          = 0;
 
 // ===================== SIRENA =============================
-unsigned long tSirena     = 0;
 unsigned long tSilenciado = 0;
 
-// ===================== BUZZER =============================
-bool buzzerActivo          = false;
-uint8_t buzzerRepeticiones = 0;
-uint8_t buzzerContador     = 0;
-unsigned long tBuzzer      = 0;
-bool estadoBuzzer          = false;
-
 // ===================== LED CONFIG =========================
 LedConfigModo ledConfigModo = LEDCFG_IDLE;
 bool progPresionado = false;
@@ -205,6 +208,16 @@ void actualizarEstadoPorton() {
   }
 
   if (nuevoEstado != estadoPortonActual) {
+
+    // Telemetría: viaje completo de un final de carrera al otro
+    if ((estadoPortonActual == ESTADO_ABRIENDO && nuevoEstado == ESTADO_ABIERTO) ||
+        (estadoPortonActual == ESTADO_CERRANDO && nuevoEstado == ESTADO_CERRADO)) {
+      Telemetria_registrarViaje(ahora - tCambioEstadoPorton);
+    }
+    if (estadoPortonActual == ESTADO_CERRANDO && nuevoEstado == ESTADO_CERRADO) {
+      Telemetria_registrarCiclo();
+    }
+
     estadoPortonPrevio = estadoPortonActual;
     estadoPortonActual = nuevoEstado;
     tCambioEstadoPorton = ahora;
@@ -301,6 +314,12 @@ void setup() {
   pinMode(PIN_FC_CERRADO, INPUT_PULLUP);
   pinMode(PIN_FC_ABIERTO, INPUT_PULLUP);
 
+  if (PRODUCTO.semaforo) {
+    pinMode(PIN_OUT1, OUTPUT);
+    pinMode(PIN_OUT2, OUTPUT);
+    pinMode(PIN_OUT3, OUTPUT);
+  }
+
   // -----------------------
   // Estados iniciales
   // -----------------------
@@ -319,8 +338,15 @@ void setup() {
   // -----------------------
   // Servicios
   // -----------------------
+  Patrones_begin();
+  CorrienteMotor_begin();
+  Patron_reproducir(CANAL_LED_VERDE, PATRON_HEARTBEAT);
+
   WiFiManager_begin();
   iniciarWeb();
+  Telemetria_begin();
+  ProtocoloUDP_begin();
+  PuenteMQTT_begin();
 
   Serial.println("Sistema iniciado");
 }
@@ -331,31 +357,51 @@ void setup() {
 // =================================================================================
 void loop() {
 
+  unsigned long tInicioLoop = micros();
+  DIAG_INICIO();
+
   // 1. Entradas
   procesarEntradasUsuario();
+  DIAG_MARCA(DIAG_ENTRADAS);
 
-  // 2. Barrera
+  // 2. Barrera y corriente de motor (misma prioridad)
   procesarBarrera();
+  if (PRODUCTO.corrienteMotor) procesarCorrienteMotor();
+  DIAG_MARCA(DIAG_BARRERA);
 
   // 3. Estado del portón
   actualizarEstadoPorton();
+  DIAG_MARCA(DIAG_ESTADO);
 
   // 4. Seguridad
   procesarSeguridad();
+  DIAG_MARCA(DIAG_SEGURIDAD);
 
   // 5. Actuadores
   gestionarPulso();
-  gestionarSirena();
-  gestionarSemaforo();
+  if (PRODUCTO.sirena)   gestionarSirena();
+  if (PRODUCTO.semaforo) gestionarSemaforo();
+  DIAG_MARCA(DIAG_ACTUADORES);
 
-  // 6. Indicadores
-  gestionarLedsPlaca();
+  // 6. Indicadores (heartbeat y buzzer corren solos en el timer)
   gestionarLedConfig();
-  procesarBuzzer();
+  DIAG_MARCA(DIAG_INDICADORES);
 
   // 7. Servicios
   WiFiManager_loop();
   loopWeb();
+  ProtocoloUDP_loop();
+  PuenteMQTT_loop();
+
+  // 8. Telemetría (incluye el costo de todo el loop, también el cierre de minuto)
+  Telemetria_loop();
+  Telemetria_registrarLoop(micros() - tInicioLoop);
+  DIAG_MARCA(DIAG_SERVICIOS);
+  DIAG_FIN();
+
+#ifdef DIAG_LOOP
+  verificarInvariantes();
+#endif
 }
 
 // =================================================================================
@@ -364,6 +410,8 @@ void loop() {
 
 void registrarEvento(String msg, String userForzado) {
   // TODO: implementar en módulo Memoria
+  PuenteMQTT_publicarEvento(msg.c_str(),
+                            userForzado.length() ? userForzado.c_str() : ultimoUsuario);
 }
 
 void procesarEntradasUsuario() {
@@ -391,16 +439,16 @@ void procesarEntradasUsuario() {
     }
     else {
       // Solo botón manual puede disparar pánico por tiempo
-      if (btnManual && !panicoEnclavado &&
+      if (PRODUCTO.panico && btnManual && !panicoEnclavado &&
           (ahora - tInicioPresion >= TIEMPO_PANICO_MS)) {
 
         panicoEnclavado = true;
         panicoDisparadoEnEstaPulsacion = true;
         estadoSeguridad = SEG_DISPARADA;
         estadoSirena = SIR_SONANDO;
-        tSirena = ahora;
 
         registrarEvento("Alarma por PÁNICO");
+        Telemetria_registrarAlarma();
       }
     }
 
@@ -428,7 +476,7 @@ void procesarEntradasUsuario() {
       panicoEnclavado = false;
       estadoSeguridad = SEG_NORMAL;
       estadoSirena = SIR_APAGADA;
-      digitalWrite(PIN_SIRENA, LOW);
+      Patron_detener(CANAL_SIRENA);
       strcpy(ultimoUsuario, "Sistema");
       return;
     }
@@ -497,10 +545,6 @@ void procesarEntradasUsuario() {
  
   }
 }
- 
- void beep(uint8_t veces) {
-  // TODO: implementar buzzer (v18)
-}
 
 void procesarBarrera() {
 
@@ -529,19 +573,90 @@ void procesarBarrera() {
   estadoPrevioBarrera = barreraCortada;
 }
 
+void procesarCorrienteMotor() {
+
+  static EstadoPorton  estadoInformado   = ESTADO_DESCONOCIDO;
+  static unsigned long tComandoInformado = 0;
+  static bool          desarmadoSensores = false;   // Hasta el próximo cambio de estado
+
+  // --------------------------------------------------
+  // Informar inicio / fin de movimiento al módulo
+  // --------------------------------------------------
+  if (estadoPortonActual != estadoInformado) {
+
+    if (estadoPortonActual == ESTADO_ABRIENDO) {
+      CorrienteMotor_inicioMovimiento(MOTOR_ABRIENDO);
+    } else if (estadoPortonActual == ESTADO_CERRANDO) {
+      CorrienteMotor_inicioMovimiento(MOTOR_CERRANDO);
+    } else {
+      bool viajeCompleto =
+        (estadoInformado == ESTADO_ABRIENDO && estadoPortonActual == ESTADO_ABIERTO) ||
+        (estadoInformado == ESTADO_CERRANDO && estadoPortonActual == ESTADO_CERRADO);
+      CorrienteMotor_finMovimiento(viajeCompleto);
+    }
+
+    estadoInformado   = estadoPortonActual;
+    tComandoInformado = tUltimoComandoAutorizado;   // El comando que inició el viaje
+    desarmadoSensores = false;
+  }
+
+  // --------------------------------------------------
+  // Comando a mitad de viaje: el motor para o invierte sin cambiar el estado.
+  // Se rearma la corrida (posición desde cero) sin aprender de ella.
+  // Si el pulso lo pidió la barrera o la corriente, el motor invierte junto al
+  // obstáculo y el sentido real es desconocido: se desarma hasta que la máquina
+  // de estados informe un sentido o un final de carrera
+  // --------------------------------------------------
+  if (tUltimoComandoAutorizado != tComandoInformado) {
+    if (strcmp(ultimoUsuario, "Sensores") == 0) desarmadoSensores = true;
+
+    if (desarmadoSensores) {
+      CorrienteMotor_finMovimiento(false);
+    } else if (estadoPortonActual == ESTADO_ABRIENDO) {
+      CorrienteMotor_inicioMovimiento(MOTOR_ABRIENDO, false);
+    } else if (estadoPortonActual == ESTADO_CERRANDO) {
+      CorrienteMotor_inicioMovimiento(MOTOR_CERRANDO, false);
+    }
+    tComandoInformado = tUltimoComandoAutorizado;
+  }
+
+  // --------------------------------------------------
+  // Pico de corriente → mismo tratamiento que la barrera
+  // --------------------------------------------------
+  if (!CorrienteMotor_obstruccion()) return;
+
+  tVisualObstaculo = millis();
+  solicitudPulso = true;          // Orden de parada / reapertura
+  tUltimoPulsoEnviado = 0;        // Fuerza aceptación inmediata
+  strcpy(ultimoUsuario, "Sensores");
+  registrarEvento("Obstrucción por corriente de motor", "Sensores");
+}
+
 void procesarSeguridad() {
 
-  if (!sistemaInicializado) return;
-  if (estadoPortonActual == ESTADO_DESCONOCIDO) return;
-  if (modoMantenimiento || panicoEnclavado) return;
+  // --------------------------------------------------
+  // Variables internas del módulo
+  // --------------------------------------------------
+  static unsigned long tFCAbiertoDesde = 0;
+  static unsigned long tInicioLatente  = 0;
+
+  // Sin vigilancia el conteo de sabotaje se descarta: al retomarla arranca de
+  // cero (si no, al soltar un pánico podía dispararse al instante)
+  if (!sistemaInicializado ||
+      estadoPortonActual == ESTADO_DESCONOCIDO ||
+      modoMantenimiento || panicoEnclavado) {
+    tFCAbiertoDesde = 0;
+    return;
+  }
 
   // --------------------------------------------------
   // Emergencia activa: estado válido, nunca es sabotaje
   // --------------------------------------------------
   if (emergenciaActiva) {
+    tFCAbiertoDesde = 0;
     estadoSeguridadUI = 0;
     estadoSirena = SIR_APAGADA;
-    digitalWrite(PIN_SIRENA, LOW);
+    Patron_detener(CANAL_SIRENA);
     return;
   }
 
@@ -557,16 +672,10 @@ void procesarSeguridad() {
   else if (ahora - tVisualObstaculo < 5000)       estadoSeguridadUI = 4;
   else                                            estadoSeguridadUI = 0;
 
-  // --------------------------------------------------
-  // Variables internas del módulo
-  // --------------------------------------------------
-  static unsigned long tFCAbiertoDesde = 0;
-  static unsigned long tInicioLatente  = 0;
-
   // --------------------------------------------------
 // Sabotaje: FC PC abierto en portón cerrado estable
 // --------------------------------------------------
-if (portonEstuvoCerradoEstable && estadoSeguridad == SEG_NORMAL) {
+if (PRODUCTO.sabotaje && portonEstuvoCerradoEstable && estadoSeguridad == SEG_NORMAL) {
 
   if (!fcCerrado) {
 
@@ -577,6 +686,7 @@ if (portonEstuvoCerradoEstable && estadoSeguridad == SEG_NORMAL) {
       estadoSeguridad = SEG_DISPARADA;
       tInicioLatente = 0;
       registrarEvento("Alarma: Sabotaje FC PC", "Sistema");
+      Telemetria_registrarAlarma();
     }
 
   } else {
@@ -603,8 +713,8 @@ if (portonEstuvoCerradoEstable && estadoSeguridad == SEG_NORMAL) {
       } else {
         estadoSeguridad = SEG_DISPARADA;
         estadoSirena = SIR_SONANDO;
-        tSirena = ahora;
         registrarEvento("Alarma re-disparada por falla persistente", "Sistema");
+        Telemetria_registrarAlarma();
       }
 
       tInicioLatente = 0;
@@ -617,43 +727,38 @@ if (portonEstuvoCerradoEstable && estadoSeguridad == SEG_NORMAL) {
 
 void gestionarSirena() {
 
-  unsigned long ahora = millis();
+  // La cadencia (sonando / pausa / beep) la ejecuta el timer de Patrones.
+  // Acá solo se decide QUÉ patrón corresponde.
 
   // --------------------------------------------------
   // Beep corto por error puntual
   // --------------------------------------------------
   if (beepPendiente) {
     estadoSirena = SIR_BEEP_ERROR;
-    tSirena = ahora;
-    digitalWrite(PIN_SIRENA, HIGH);
+    Patron_reproducir(CANAL_SIRENA, PATRON_BEEP_ERROR);
     beepPendiente = false;
     return;
   }
 
   if (estadoSirena == SIR_BEEP_ERROR) {
-    if (ahora - tSirena >= DURACION_BEEP_ERROR) {
-      digitalWrite(PIN_SIRENA, LOW);
-      estadoSirena = SIR_APAGADA;
+    if (Patron_activo(CANAL_SIRENA)) return;
 
-      // Si sigue en alarma, vuelve a sonar normal
-      if (estadoSeguridad == SEG_DISPARADA) {
-        estadoSirena = SIR_SONANDO;
-      }
-    }
-    return;
+    // Terminó el beep: se sigue en esta misma vuelta para que pánico / alarma
+    // vuelvan a sonar sin un hueco de una vuelta con la sirena apagada
+    estadoSirena = SIR_APAGADA;
   }
 
   // --------------------------------------------------
   // Forzados de sistema
   // --------------------------------------------------
   if (modoMantenimiento) {
-    digitalWrite(PIN_SIRENA, LOW);
+    Patron_detener(CANAL_SIRENA);
     estadoSirena = SIR_APAGADA;
     return;
   }
 
   if (panicoEnclavado) {
-    digitalWrite(PIN_SIRENA, HIGH);
+    Patron_mantener(CANAL_SIRENA, PATRON_SIRENA_CONTINUA);
     return;
   }
 
@@ -661,7 +766,7 @@ void gestionarSirena() {
   // Sistema normal
   // --------------------------------------------------
   if (estadoSeguridad == SEG_NORMAL) {
-    digitalWrite(PIN_SIRENA, LOW);
+    Patron_detener(CANAL_SIRENA);
     estadoSirena = SIR_APAGADA;
     return;
   }
@@ -670,28 +775,8 @@ void gestionarSirena() {
   // Gestión de alarma sonora
   // --------------------------------------------------
   if (estadoSeguridad == SEG_DISPARADA) {
-
-    if (estadoSirena == SIR_APAGADA) {
-      estadoSirena = SIR_SONANDO;
-      tSirena = ahora;
-    }
-
-    if (estadoSirena == SIR_SONANDO) {
-      digitalWrite(PIN_SIRENA, HIGH);
-
-      if (ahora - tSirena >= SIRENA_ON_TIEMPO) {
-        estadoSirena = SIR_PAUSA;
-        tSirena = ahora;
-      }
-    }
-    else if (estadoSirena == SIR_PAUSA) {
-      digitalWrite(PIN_SIRENA, LOW);
-
-      if (ahora - tSirena >= SIRENA_OFF_TIEMPO) {
-        estadoSirena = SIR_SONANDO;
-        tSirena = ahora;
-      }
-    }
+    Patron_mantener(CANAL_SIRENA, PATRON_SIRENA_ALARMA);
+    estadoSirena = Patron_nivel(CANAL_SIRENA) ? SIR_SONANDO : SIR_PAUSA;
   }
 }
 
@@ -751,51 +836,94 @@ void gestionarSemaforo() {
   digitalWrite(PIN_OUT3, LOW);
 }
 
-void gestionarLedsPlaca() {
+void gestionarLedConfig() {
 
-  // ---------------------------
-  // LED VERDE: heartbeat simple
-  // ---------------------------
-  static unsigned long tVerde = 0;
-  static bool estadoVerde = false;
+  static LedConfigModo modoPrevio = LEDCFG_IDLE;
 
-  if (millis() - tVerde > 1000) {   // 1 Hz heartbeat
-    tVerde = millis();
-    estadoVerde = !estadoVerde;
-    digitalWrite(PIN_LED_VERDE, estadoVerde);
+  // El destello de salida es de una sola vez: al terminar vuelve a reposo
+  if (ledConfigModo == LEDCFG_EXIT_FLASH && modoPrevio == LEDCFG_EXIT_FLASH &&
+      !Patron_activo(CANAL_LED_CONFIG)) {
+    ledConfigModo = LEDCFG_IDLE;
   }
 
-  // El LED de configuración (GPIO22) se gestiona exclusivamente
-  // en la función gestionarLedConfig()
+  if (ledConfigModo == modoPrevio) return;
+  modoPrevio = ledConfigModo;
+
+  switch (ledConfigModo) {
+    case LEDCFG_CONFIRM_1S:  Patron_reproducir(CANAL_LED_CONFIG, PATRON_LEDCFG_1S);     break;
+    case LEDCFG_CONFIRM_5S:  Patron_reproducir(CANAL_LED_CONFIG, PATRON_LEDCFG_5S);     break;
+    case LEDCFG_CONFIRM_10S: Patron_reproducir(CANAL_LED_CONFIG, PATRON_LEDCFG_10S);    break;
+    case LEDCFG_CONFIRM_15S: Patron_reproducir(CANAL_LED_CONFIG, PATRON_LEDCFG_15S);    break;
+    case LEDCFG_LEARN:       Patron_reproducir(CANAL_LED_CONFIG, PATRON_LEDCFG_LEARN);  break;
+    case LEDCFG_EXIT_FLASH:  Patron_reproducir(CANAL_LED_CONFIG, PATRON_LEDCFG_SALIDA, 10); break;
+    default:                 Patron_detener(CANAL_LED_CONFIG);                          break;
+  }
 }
 
-
 void beep(uint8_t cantidad) {
-  buzzerActivo = true;
-  buzzerRepeticiones = cantidad;
-  buzzerContador = 0;
-  estadoBuzzer = false;
-  tBuzzer = millis();
+  if (!PRODUCTO.buzzer) return;
+  Patron_reproducir(CANAL_BUZZER, PATRON_BEEP, cantidad);
 }
 
-void procesarBuzzer() {
+// =================================================================================
+// 9. INVARIANTES DE SEGURIDAD (solo build DIAG_LOOP)
+// =================================================================================
+#ifdef DIAG_LOOP
+
+// Margen por la diferencia de lectura entre procesarSeguridad() y este chequeo
+#define DIAG_TOLERANCIA_MS 100
+
+void verificarInvariantes() {
 
-  if (!buzzerActivo) return;
+  static unsigned long   tComandoPrevio  = 0;
+  static unsigned long   tFCAbiertoDiag  = 0;
+  static EstadoSeguridad seguridadPrevia = SEG_NORMAL;
 
   unsigned long ahora = millis();
-  if (ahora - tBuzzer < 120) return;
+  bool barreraCortada = (digitalRead(PIN_BARRERA) == HIGH);
+  bool fcCerrado      = entradaActiva(PIN_FC_CERRADO);
 
-  tBuzzer = ahora;
-  estadoBuzzer = !estadoBuzzer;
-  digitalWrite(PIN_BUZZER, estadoBuzzer);
+  // --------------------------------------------------
+  // 1. Nunca un pulso con barrera cortada y portón abierto
+  // --------------------------------------------------
+  if (tUltimoComandoAutorizado != tComandoPrevio) {
+    if (barreraCortada && estadoPortonActual == ESTADO_ABIERTO) {
+      Diag_violacion("Pulso con barrera cortada y porton abierto");
+    }
+    tComandoPrevio = tUltimoComandoAutorizado;
+  }
+
+  // --------------------------------------------------
+  // 2. Pánico enclavado: alarma disparada y sirena fija
+  // --------------------------------------------------
+  if (panicoEnclavado) {
+    if (estadoSeguridad != SEG_DISPARADA) {
+      Diag_violacion("Panico enclavado sin alarma disparada");
+    }
+    if (PRODUCTO.sirena && !modoMantenimiento && estadoSirena != SIR_BEEP_ERROR &&
+        !Patron_nivel(CANAL_SIRENA)) {
+      Diag_violacion("Panico enclavado con sirena apagada");
+    }
+  }
 
-  if (!estadoBuzzer) {
-    buzzerContador++;
+  // --------------------------------------------------
+  // 3. Sabotaje: nunca antes de 4 s con FC cerrado liberado
+  // --------------------------------------------------
+  if (!fcCerrado) {
+    if (tFCAbiertoDiag == 0) tFCAbiertoDiag = ahora;
+  } else {
+    tFCAbiertoDiag = 0;
+  }
 
-    if (buzzerContador >= buzzerRepeticiones) {
-      buzzerActivo = false;
-      buzzerContador = 0;
-      digitalWrite(PIN_BUZZER, LOW);
+  if (seguridadPrevia == SEG_NORMAL && estadoSeguridad == SEG_DISPARADA &&
+      !panicoEnclavado) {
+    if (tFCAbiertoDiag == 0 ||
+        ahora - tFCAbiertoDiag + DIAG_TOLERANCIA_MS < 4000) {
+      Diag_violacion("Sabotaje disparado antes de 4 s");
     }
   }
+
+  seguridadPrevia = estadoSeguridad;
 }
+
+#endif
@@ -0,0 +1,195 @@
+// =================================================================================
+// BENCHMARK – COSTO DE LOS BLOQUES DEL LOOP
+// =================================================================================
+// Mide en el host el costo por llamada de cada bloque de control y del loop()
+// completo en escenarios representativos (reposo, cierre con barrera, pánico,
+// sabotaje). Falla (código ≠ 0) si se supera algún umbral:
+//
+//   - ns por llamada (mediana de lotes): detecta regresiones groseras
+//     (trabajo O(n), Strings, esperas). Se escala con BENCH_ESCALA=<factor>
+//     en máquinas lentas o con sanitizers.
+//   - Lecturas / escrituras de GPIO y reservas de heap por vuelta: exactas,
+//     no dependen de la máquina.
+//
+// No reemplaza a DIAG_LOOP en la placa: el objetivo es que una regresión se vea
+// en CI antes de llegar al equipo.
+// =================================================================================
+
+#include "../main.cpp"
+#include "simulador.h"
+
+#include <chrono>
+#include <new>
+#include <stdlib.h>
+#include <vector>
+
+// =================================================================================
+// 1. UMBRALES
+// =================================================================================
+#define UMBRAL_BLOQUE_NS      200     // Cualquiera de los cinco bloques
+#define UMBRAL_LOOP_NS        1000    // loop() completo
+#define UMBRAL_LECTURAS       8       // digitalRead por vuelta
+#define UMBRAL_ESCRITURAS     3.01    // digitalWrite por vuelta: semáforo + timer de patrones
+#define UMBRAL_RESERVAS       0       // new / malloc por vuelta en régimen
+
+#define LOTE          1000
+#define LOTES         200
+
+// =================================================================================
+// 2. CONTEO DE RESERVAS DE HEAP
+// =================================================================================
+static uint32_t reservas = 0;
+
+void* operator new(size_t n) {
+  reservas++;
+  void* p = malloc(n ? n : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void  operator delete(void* p) noexcept         { free(p); }
+void  operator delete(void* p, size_t) noexcept { free(p); }
+
+// =================================================================================
+// 3. ESCENARIOS
+// =================================================================================
+struct Escenario {
+  const char* nombre;
+  bool fcCerrado;
+  bool fcAbierto;
+  bool manual;
+  bool barreraAlterna;      // Corta / libera la barrera cada vuelta
+  EstadoPorton estado;      // Estado forzado antes de medir (DESCONOCIDO = no forzar)
+  bool panico;
+  EstadoSeguridad seguridad;
+};
+
+static const Escenario escenarios[] = {
+  { "reposo",          true,  false, false, false, ESTADO_DESCONOCIDO, false, SEG_NORMAL    },
+  { "cierre+barrera",  false, false, false, true,  ESTADO_CERRANDO,    false, SEG_NORMAL    },
+  { "panico",          true,  false, true,  false, ESTADO_DESCONOCIDO, true,  SEG_DISPARADA },
+  { "sabotaje",        false, false, false, false, ESTADO_CERRADO,     false, SEG_DISPARADA },
+};
+
+static void prepararEscenario(const Escenario& e) {
+
+  sim_fijarEntrada(PIN_FC_CERRADO, e.fcCerrado ? LOW : HIGH);
+  sim_fijarEntrada(PIN_FC_ABIERTO, e.fcAbierto ? LOW : HIGH);
+  sim_fijarEntrada(PIN_BTN_MANUAL, e.manual ? LOW : HIGH);
+  sim_fijarEntrada(PIN_RF_RX,      HIGH);
+  sim_fijarEntrada(PIN_BTN_PROG,   HIGH);
+  sim_fijarEntrada(PIN_BARRERA,    LOW);
+
+  // Unas vueltas para que los bloques lleguen a régimen
+  for (int i = 0; i < 200; i++) { loop(); sim_avanzar(10); }
+
+  if (e.estado != ESTADO_DESCONOCIDO) estadoPortonActual = e.estado;
+  estadoSeguridad = e.seguridad;
+  panicoEnclavado = e.panico;
+  botonPresionado = e.manual;
+
+  for (int i = 0; i < 10; i++) { loop(); sim_avanzar(1); }
+}
+
+// =================================================================================
+// 4. MEDICIÓN
+// =================================================================================
+static double escala = 1.0;
+static int fallas = 0;
+
+static double nsAhora() {
+  using namespace std::chrono;
+  return (double)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Mediana de LOTES lotes de LOTE llamadas, en ns por llamada
+template <typename F>
+static double medir(const Escenario& e, F bloque) {
+
+  std::vector<double> lotes;
+  lotes.reserve(LOTES);
+  bool barrera = false;
+
+  for (int l = 0; l < LOTES; l++) {
+    double t0 = nsAhora();
+    for (int i = 0; i < LOTE; i++) {
+      if (e.barreraAlterna) {
+        barrera = !barrera;
+        sim_fijarEntrada(PIN_BARRERA, barrera ? HIGH : LOW);
+      }
+      bloque();
+    }
+    lotes.push_back((nsAhora() - t0) / LOTE);
+    sim_avanzar(1);
+  }
+
+  std::sort(lotes.begin(), lotes.end());
+  return lotes[LOTES / 2];
+}
+
+static void verificar(const char* escenario, const char* que, double valor, double umbral) {
+  bool ok = valor <= umbral;
+  printf("  %-16s %-26s %10.2f  (umbral %.2f)%s\n", escenario, que, valor, umbral,
+         ok ? "" : "  <-- EXCEDIDO");
+  if (!ok) fallas++;
+}
+
+static void medirEscenario(const Escenario& e) {
+
+  prepararEscenario(e);
+
+  struct { const char* nombre; void (*fn)(); } bloques[] = {
+    { "procesarEntradasUsuario", procesarEntradasUsuario },
+    { "procesarBarrera",         procesarBarrera         },
+    { "actualizarEstadoPorton",  actualizarEstadoPorton  },
+    { "procesarSeguridad",       procesarSeguridad       },
+    { "gestionarPulso",          gestionarPulso          },
+  };
+
+  for (auto& b : bloques) {
+    // El escenario se re-prepara: un bloque puede cambiar el estado
+    prepararEscenario(e);
+    verificar(e.nombre, b.nombre, medir(e, b.fn), UMBRAL_BLOQUE_NS * escala);
+  }
+
+  prepararEscenario(e);
+  verificar(e.nombre, "loop() [ns]", medir(e, loop), UMBRAL_LOOP_NS * escala);
+
+  // ---- Costos exactos por vuelta (sin eventos: barrera quieta) ----
+  prepararEscenario(e);
+  const int vueltas = 1000;
+  sim_limpiarContadores();
+  reservas = 0;
+  for (int i = 0; i < vueltas; i++) { loop(); sim_avanzar(1); }
+  ContadoresES c = sim_contadores();
+
+  verificar(e.nombre, "digitalRead / vuelta",  (double)c.lecturas / vueltas,   UMBRAL_LECTURAS);
+  verificar(e.nombre, "digitalWrite / vuelta", (double)c.escrituras / vueltas, UMBRAL_ESCRITURAS);
+  verificar(e.nombre, "reservas heap / vuelta", (double)reservas / vueltas,    UMBRAL_RESERVAS);
+}
+
+// =================================================================================
+// 5. PUNTO DE ENTRADA
+// =================================================================================
+int main() {
+
+  const char* env = getenv("BENCH_ESCALA");
+  if (env && atof(env) > 0) escala = atof(env);
+
+  sim_reiniciarTiempo(1000);
+  setup();
+
+#if defined(PRODUCTO_BASICO)
+  const char* variante = "BASICO";
+#elif defined(PRODUCTO_RESIDENCIAL)
+  const char* variante = "RESIDENCIAL";
+#else
+  const char* variante = "COMPLETO";
+#endif
+
+  printf("PRODUCTO_%s – costo por llamada (mediana de %d lotes de %d) y por vuelta:\n",
+         variante, LOTES, LOTE);
+  for (const Escenario& e : escenarios) medirEscenario(e);
+
+  if (fallas) printf("%d umbrales excedidos\n", fallas);
+  return fallas ? 1 : 0;
+}
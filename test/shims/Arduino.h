@@ -0,0 +1,122 @@
+#pragma once
+
+// =================================================================================
+// SHIM HOST – Arduino / ESP32 mínimo para compilar el firmware en Linux
+// =================================================================================
+// El tiempo y los pines los controla el test (ver simulador.h).
+// =================================================================================
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <algorithm>
+#include <string>
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+
+#define HIGH          1
+#define LOW           0
+#define INPUT         0x01
+#define OUTPUT        0x03
+#define INPUT_PULLUP  0x05
+
+#define IRAM_ATTR
+#define ARDUINO_ISR_ATTR
+#define DRAM_ATTR
+
+// ===================== TIEMPO / PINES =====================
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+void pinMode(uint8_t pin, uint8_t modo);
+void digitalWrite(uint8_t pin, uint8_t valor);
+int  digitalRead(uint8_t pin);
+int8_t digitalPinToAnalogChannel(uint8_t pin);
+
+// ===================== STRING / PRINT =====================
+class String : public std::string {
+public:
+  String(const char* s = "") : std::string(s ? s : "") {}
+  String(const std::string& s) : std::string(s) {}
+  unsigned int length() const { return (unsigned int)std::string::length(); }
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t n) {
+    for (size_t i = 0; i < n; i++) write(buf[i]);
+    return n;
+  }
+  size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t println(const char* s) { size_t n = print(s); return n + print("\n"); }
+  size_t printf(const char* fmt, ...) {
+    char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    return (n > 0) ? write((const uint8_t*)buf, (size_t)min(n, (int)sizeof(buf) - 1)) : 0;
+  }
+};
+
+class HardwareSerial : public Print {
+public:
+  void begin(unsigned long) {}
+  size_t write(uint8_t) override { return 1; }
+};
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+  uint32_t getCycleCount();
+  uint32_t getCpuFreqMHz() { return 240; }
+};
+extern EspClass ESP;
+
+// ===================== FREERTOS =====================
+struct portMUX_TYPE {
+  std::atomic_flag f = ATOMIC_FLAG_INIT;
+};
+#define portMUX_INITIALIZER_UNLOCKED {}
+
+inline void shimEntrar(portMUX_TYPE* m) { while (m->f.test_and_set(std::memory_order_acquire)) {} }
+inline void shimSalir(portMUX_TYPE* m)  { m->f.clear(std::memory_order_release); }
+
+#define portENTER_CRITICAL(m)     shimEntrar(m)
+#define portEXIT_CRITICAL(m)      shimSalir(m)
+#define portENTER_CRITICAL_ISR(m) shimEntrar(m)
+#define portEXIT_CRITICAL_ISR(m)  shimSalir(m)
+
+typedef void* TaskHandle_t;
+typedef int   BaseType_t;
+typedef uint32_t TickType_t;
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdPASS  1
+#define portMAX_DELAY 0xFFFFFFFF
+#define pdMS_TO_TICKS(ms) (ms)
+
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void*), const char* nombre, uint32_t pila,
+                                   void* arg, int prioridad, TaskHandle_t* handle, int core);
+void vTaskDelay(TickType_t ticks);
+
+// Las notificaciones no despiertan a nadie: el test ejecuta el cuerpo de la tarea
+void     xTaskNotifyGive(TaskHandle_t tarea);
+uint32_t ulTaskNotifyTake(BaseType_t limpiar, TickType_t espera);
+
+// ===================== HW TIMER =====================
+struct hw_timer_t;
+hw_timer_t* timerBegin(uint8_t num, uint16_t divisor, bool ascendente);
+void timerAttachInterrupt(hw_timer_t* t, void (*fn)(), bool flanco);
+void timerAlarmWrite(hw_timer_t* t, uint64_t cuenta, bool recarga);
+void timerAlarmEnable(hw_timer_t* t);
@@ -0,0 +1,10 @@
+#pragma once
+// Valores de prueba (el Config.h real no es parte de este árbol)
+#define DURACION_PULSO_MS      500
+#define SEPARACION_PULSOS_MS   1500
+#define MAX_TIEMPO_MOVIMIENTO  60000
+#define TIEMPO_PANICO_MS       3000
+#define TIEMPO_REBOTE_MS       50
+#define SIRENA_ON_TIEMPO       30000
+#define SIRENA_OFF_TIEMPO      10000
+#define DURACION_BEEP_ERROR    300
@@ -0,0 +1,17 @@
+#pragma once
+// Mapa de pines de prueba (el Config_Hardware.h real no es parte de este árbol)
+#define PIN_RELE_PULSO       4
+#define PIN_BARRERA          5
+#define PIN_FC_CERRADO       18
+#define PIN_FC_ABIERTO       19
+#define PIN_BTN_MANUAL       21
+#define PIN_RF_RX            23
+#define PIN_BTN_PROG         0
+#define PIN_SIRENA           25
+#define PIN_BUZZER           26
+#define PIN_LED_VERDE        2
+#define PIN_LED_CONFIG       22
+#define PIN_OUT1             12
+#define PIN_OUT2             13
+#define PIN_OUT3             14
+#define PIN_CORRIENTE_MOTOR  36
@@ -0,0 +1,42 @@
+#pragma once
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// NVS en memoria: persiste mientras viva el proceso (simula reinicios)
+class Preferences {
+public:
+  bool begin(const char* ns, bool soloLectura = false) { espacio = ns; (void)soloLectura; return true; }
+  void end() {}
+
+  size_t getBytesLength(const char* clave) {
+    auto it = datos().find(espacio + "/" + clave);
+    return it == datos().end() ? 0 : it->second.size();
+  }
+  size_t getBytes(const char* clave, void* buf, size_t largo) {
+    auto it = datos().find(espacio + "/" + clave);
+    if (it == datos().end()) return 0;
+    size_t n = std::min(largo, it->second.size());
+    memcpy(buf, it->second.data(), n);
+    return n;
+  }
+  size_t putBytes(const char* clave, const void* buf, size_t largo) {
+    const uint8_t* p = (const uint8_t*)buf;
+    datos()[espacio + "/" + clave].assign(p, p + largo);
+    escrituras()++;
+    return largo;
+  }
+
+  static std::map<std::string, std::vector<uint8_t>>& datos() {
+    static std::map<std::string, std::vector<uint8_t>> d;
+    return d;
+  }
+  static uint32_t& escrituras() {
+    static uint32_t n = 0;
+    return n;
+  }
+
+private:
+  std::string espacio;
+};
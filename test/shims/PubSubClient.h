@@ -0,0 +1,169 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// =================================================================================
+// SHIM HOST – PubSubClient contra un broker simulado en memoria
+// =================================================================================
+// El test maneja el broker (caída, fallas de publicación, latencia, mensajes
+// entrantes y retenidos) e inspecciona lo publicado. Thread-safe: la tarea del
+// puente puede correr en otro hilo.
+// =================================================================================
+
+struct MensajeMQTT {
+  std::string topic;
+  std::string payload;
+  bool        retenido;
+};
+
+class BrokerSimulado {
+public:
+  bool     disponible   = true;     // false = connect() falla
+  bool     fallaPublicar = false;   // publish() devuelve false
+  uint32_t demoraUs     = 0;        // Latencia por publicación (broker lento)
+
+  static BrokerSimulado& instancia() {
+    static BrokerSimulado b;
+    return b;
+  }
+
+  // Mensaje de otro cliente: se guarda si es retenido y se entrega si hay suscripción
+  void inyectar(const std::string& topic, const std::string& payload, bool retenido) {
+    std::lock_guard<std::mutex> l(mtx);
+    recibirLocked(topic, payload, retenido);
+  }
+
+  // Corta la conexión del equipo (como una caída del broker o de la red)
+  void desconectar() {
+    std::lock_guard<std::mutex> l(mtx);
+    conectado = false;
+    suscripciones.clear();
+    entrantes.clear();
+  }
+
+  std::vector<MensajeMQTT> publicados() {
+    std::lock_guard<std::mutex> l(mtx);
+    return historial;
+  }
+  void limpiarPublicados() {
+    std::lock_guard<std::mutex> l(mtx);
+    historial.clear();
+  }
+  bool retenido(const std::string& topic, std::string* payload = nullptr) {
+    std::lock_guard<std::mutex> l(mtx);
+    auto it = retenidos.find(topic);
+    if (it == retenidos.end()) return false;
+    if (payload) *payload = it->second;
+    return true;
+  }
+  bool estaConectado() {
+    std::lock_guard<std::mutex> l(mtx);
+    return conectado;
+  }
+
+private:
+  friend class PubSubClient;
+
+  std::mutex mtx;
+  bool conectado = false;
+  std::set<std::string> suscripciones;
+  std::map<std::string, std::string> retenidos;
+  std::deque<MensajeMQTT> entrantes;
+  std::vector<MensajeMQTT> historial;
+
+  void recibirLocked(const std::string& topic, const std::string& payload, bool retenido) {
+    if (retenido) {
+      if (payload.empty()) retenidos.erase(topic);
+      else                 retenidos[topic] = payload;
+    }
+    if (conectado && suscripciones.count(topic)) entrantes.push_back({ topic, payload, false });
+  }
+};
+
+typedef void (*CallbackMQTT)(char*, uint8_t*, unsigned int);
+
+class PubSubClient {
+public:
+  explicit PubSubClient(WiFiClient&) {}
+
+  PubSubClient& setServer(const char*, uint16_t) { return *this; }
+  PubSubClient& setCallback(CallbackMQTT fn) { callback = fn; return *this; }
+  PubSubClient& setSocketTimeout(uint16_t) { return *this; }
+  bool setBufferSize(uint16_t largo) { buffer.resize(largo); return true; }
+
+  bool connect(const char*, const char*, const char*, const char* willTopic, uint8_t, bool,
+               const char* willMsg) {
+    BrokerSimulado& b = BrokerSimulado::instancia();
+    std::lock_guard<std::mutex> l(b.mtx);
+    if (!b.disponible) return false;
+    b.conectado = true;
+    will = MensajeMQTT{ willTopic, willMsg, true };
+    return true;
+  }
+
+  bool connected() { return BrokerSimulado::instancia().estaConectado(); }
+
+  bool publish(const char* topic, const char* payload, bool retenido) {
+    BrokerSimulado& b = BrokerSimulado::instancia();
+    uint32_t demora;
+    {
+      std::lock_guard<std::mutex> l(b.mtx);
+      if (!b.conectado || b.fallaPublicar) return false;
+      demora = b.demoraUs;
+    }
+    // La latencia la paga quien publica (la tarea), no el broker
+    if (demora) std::this_thread::sleep_for(std::chrono::microseconds(demora));
+
+    std::lock_guard<std::mutex> l(b.mtx);
+    b.historial.push_back({ topic, payload, retenido });
+    b.recibirLocked(topic, payload, retenido);
+    return true;
+  }
+
+  bool subscribe(const char* topic) {
+    BrokerSimulado& b = BrokerSimulado::instancia();
+    std::lock_guard<std::mutex> l(b.mtx);
+    if (!b.conectado) return false;
+    b.suscripciones.insert(topic);
+    auto it = b.retenidos.find(topic);
+    if (it != b.retenidos.end()) b.entrantes.push_back({ topic, it->second, true });
+    return true;
+  }
+
+  // Entrega como máximo un mensaje por llamada (como la librería real)
+  bool loop() {
+    BrokerSimulado& b = BrokerSimulado::instancia();
+    MensajeMQTT m;
+    {
+      std::lock_guard<std::mutex> l(b.mtx);
+      if (!b.conectado) return false;
+      if (b.entrantes.empty()) return true;
+      m = b.entrantes.front();
+      b.entrantes.pop_front();
+    }
+    if (!callback) return true;
+
+    // El payload vive en el buffer del cliente, como en la librería real
+    std::string topic = m.topic;
+    if (buffer.size() < m.payload.size()) buffer.resize(m.payload.size());
+    memcpy(buffer.data(), m.payload.data(), m.payload.size());
+    callback(&topic[0], buffer.data(), (unsigned int)m.payload.size());
+    return true;
+  }
+
+  const MensajeMQTT& ultimaVoluntad() const { return will; }
+
+private:
+  CallbackMQTT callback = nullptr;
+  std::vector<uint8_t> buffer;
+  MensajeMQTT will;
+};
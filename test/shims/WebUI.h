@@ -0,0 +1,3 @@
+#pragma once
+inline void iniciarWeb() {}
+inline void loopWeb() {}
@@ -0,0 +1,13 @@
+#pragma once
+#include <Arduino.h>
+
+#define WL_CONNECTED    3
+#define WL_DISCONNECTED 6
+
+class WiFiClient {};
+
+class WiFiClass {
+public:
+  int status();
+};
+extern WiFiClass WiFi;
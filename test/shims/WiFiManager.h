@@ -0,0 +1,4 @@
+#pragma once
+inline void WiFiManager_begin() {}
+inline void WiFiManager_loop() {}
+inline void WiFiManager_resetCredentials() {}
@@ -0,0 +1,62 @@
+#pragma once
+
+// Shim host del ADC continuo (IDF 4.4). Sin muestras: los tests de
+// CorrienteMotor inyectan bloques directamente.
+#include <stdint.h>
+
+typedef int esp_err_t;
+#define ESP_OK                 0
+#define ESP_ERR_INVALID_STATE  0x103
+#define BIT(n)                 (1u << (n))
+
+#define SOC_ADC_DIGI_RESULT_BYTES  2
+#define SOC_ADC_DIGI_MAX_BITWIDTH  12
+#define ADC_MAX_DELAY              0xFFFFFFFF
+
+enum {
+  ADC_ATTEN_DB_11              = 3,
+  ADC_CONV_SINGLE_UNIT_1       = 1,
+  ADC_DIGI_OUTPUT_FORMAT_TYPE1 = 0
+};
+
+struct adc_digi_init_config_t {
+  uint32_t max_store_buf_size;
+  uint32_t conv_num_each_intr;
+  uint32_t adc1_chan_mask;
+  uint32_t adc2_chan_mask;
+};
+
+struct adc_digi_pattern_config_t {
+  uint8_t atten;
+  uint8_t channel;
+  uint8_t unit;
+  uint8_t bit_width;
+};
+
+struct adc_digi_configuration_t {
+  bool     conv_limit_en;
+  uint32_t conv_limit_num;
+  uint32_t pattern_num;
+  adc_digi_pattern_config_t* adc_pattern;
+  uint32_t sample_freq_hz;
+  int      conv_mode;
+  int      format;
+};
+
+struct adc_digi_output_data_t {
+  union {
+    struct {
+      uint16_t data    : 12;
+      uint16_t channel : 4;
+    } type1;
+    uint16_t val;
+  };
+};
+
+inline esp_err_t adc_digi_initialize(const adc_digi_init_config_t*)           { return ESP_OK; }
+inline esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t*) { return ESP_OK; }
+inline esp_err_t adc_digi_start()                                              { return ESP_OK; }
+inline esp_err_t adc_digi_read_bytes(uint8_t*, uint32_t, uint32_t* leidos, uint32_t) {
+  *leidos = 0;
+  return ESP_OK;
+}
@@ -0,0 +1,2 @@
+#pragma once
+// Shim host: sin contenido
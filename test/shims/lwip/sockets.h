@@ -0,0 +1,8 @@
+#pragma once
+
+// Shim host: la API de sockets de lwIP es la de POSIX
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
@@ -0,0 +1,46 @@
+#pragma once
+
+// Shim host de mbedtls_md (solo HMAC-SHA256) sobre tools/Sha256
+#include <stdint.h>
+#include <stddef.h>
+
+#include "../../../tools/Sha256.h"
+
+enum mbedtls_md_type_t { MBEDTLS_MD_SHA256 = 6 };
+
+struct mbedtls_md_info_t { mbedtls_md_type_t tipo; };
+
+struct mbedtls_md_context_t {
+  HmacSha256 hmac;
+};
+
+inline const mbedtls_md_info_t* mbedtls_md_info_from_type(mbedtls_md_type_t) {
+  static const mbedtls_md_info_t info = { MBEDTLS_MD_SHA256 };
+  return &info;
+}
+
+inline void mbedtls_md_init(mbedtls_md_context_t*) {}
+
+inline int mbedtls_md_setup(mbedtls_md_context_t*, const mbedtls_md_info_t* info, int hmac) {
+  return (info && hmac) ? 0 : -1;
+}
+
+inline int mbedtls_md_hmac_starts(mbedtls_md_context_t* c, const unsigned char* clave, size_t largo) {
+  HmacSha256_iniciar(c->hmac, clave, largo);
+  return 0;
+}
+
+inline int mbedtls_md_hmac_reset(mbedtls_md_context_t* c) {
+  HmacSha256_reiniciar(c->hmac);
+  return 0;
+}
+
+inline int mbedtls_md_hmac_update(mbedtls_md_context_t* c, const unsigned char* datos, size_t largo) {
+  HmacSha256_agregar(c->hmac, datos, largo);
+  return 0;
+}
+
+inline int mbedtls_md_hmac_finish(mbedtls_md_context_t* c, unsigned char* salida) {
+  HmacSha256_terminar(c->hmac, salida);
+  return 0;
+}
@@ -0,0 +1,3 @@
+#pragma once
+// Sin credenciales: los módulos de red quedan deshabilitados salvo que el
+// test defina sus claves al compilar.
@@ -0,0 +1,125 @@
+#include "simulador.h"
+#include "WiFi.h"
+#include "esp_system.h"
+
+#include <chrono>
+#include <thread>
+
+// =================================================================================
+// 1. ESTADO
+// =================================================================================
+static unsigned long tSim = 0;
+static uint8_t entradas[SIM_PINES];
+static uint8_t salidas[SIM_PINES];
+static void (*alEscribir)(uint8_t, uint8_t) = nullptr;
+static ContadoresES contadores;
+static int tareas = 0;
+
+static void (*isrTimer)() = nullptr;
+static unsigned long periodoTimerUs = 0;
+static bool timerHabilitado = false;
+static unsigned long tProximoTick = 0;
+
+static bool wifiConectado = false;
+
+HardwareSerial Serial;
+EspClass ESP;
+WiFiClass WiFi;
+
+// =================================================================================
+// 2. SIMULADOR
+// =================================================================================
+void sim_reiniciarTiempo(unsigned long ms) {
+  tSim = ms;
+  tProximoTick = ms + periodoTimerUs / 1000;
+}
+
+void sim_avanzar(unsigned long ms) {
+  unsigned long fin = tSim + ms;
+  while (timerHabilitado && isrTimer && periodoTimerUs >= 1000 && tProximoTick <= fin) {
+    tSim = tProximoTick;
+    isrTimer();
+    tProximoTick += periodoTimerUs / 1000;
+  }
+  tSim = fin;
+}
+
+void sim_fijarEntrada(uint8_t pin, int nivel) { entradas[pin % SIM_PINES] = nivel ? HIGH : LOW; }
+int  sim_salida(uint8_t pin)                  { return salidas[pin % SIM_PINES]; }
+
+void sim_alEscribir(void (*fn)(uint8_t, uint8_t)) { alEscribir = fn; }
+
+ContadoresES sim_contadores()  { return contadores; }
+void sim_limpiarContadores()   { contadores = ContadoresES(); }
+int  sim_tareasCreadas()       { return tareas; }
+
+void sim_wifiConectado(bool c) { wifiConectado = c; }
+
+// =================================================================================
+// 3. ARDUINO
+// =================================================================================
+unsigned long millis() { return tSim; }
+unsigned long micros() { return tSim * 1000UL; }
+void delay(unsigned long ms) { sim_avanzar(ms); }
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t pin, uint8_t valor) {
+  contadores.escrituras++;
+  salidas[pin % SIM_PINES] = valor ? HIGH : LOW;
+  if (alEscribir) alEscribir(pin, valor);
+}
+
+int digitalRead(uint8_t pin) {
+  contadores.lecturas++;
+  return entradas[pin % SIM_PINES];
+}
+
+int8_t digitalPinToAnalogChannel(uint8_t pin) {
+  return (pin >= 32 && pin <= 39) ? (int8_t)((pin - 32 + 4) % 8) : -1;
+}
+
+uint32_t EspClass::getCycleCount() {
+  using namespace std::chrono;
+  return (uint32_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+int WiFiClass::status() { return wifiConectado ? WL_CONNECTED : WL_DISCONNECTED; }
+
+// =================================================================================
+// 4. FREERTOS / TIMER
+// =================================================================================
+BaseType_t xTaskCreatePinnedToCore(void (*)(void*), const char*, uint32_t, void*, int,
+                                   TaskHandle_t* handle, int) {
+  tareas++;
+  if (handle) *handle = reinterpret_cast<TaskHandle_t>((intptr_t)tareas);
+  return pdPASS;
+}
+
+void     xTaskNotifyGive(TaskHandle_t) {}
+uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 1; }
+
+void vTaskDelay(TickType_t ticks) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+hw_timer_t* timerBegin(uint8_t, uint16_t, bool) {
+  return reinterpret_cast<hw_timer_t*>(&isrTimer);
+}
+
+void timerAttachInterrupt(hw_timer_t*, void (*fn)(), bool) { isrTimer = fn; }
+
+void timerAlarmWrite(hw_timer_t*, uint64_t cuenta, bool) {
+  periodoTimerUs = (unsigned long)cuenta;     // divisor 80 → 1 tick = 1 µs
+  tProximoTick = tSim + periodoTimerUs / 1000;
+}
+
+void timerAlarmEnable(hw_timer_t*) { timerHabilitado = true; }
+
+uint32_t esp_random() {
+  static uint32_t x = 0x2545F491;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return x;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// =================================================================================
+// SIMULADOR – control de tiempo, pines y tareas para los tests host
+// =================================================================================
+
+#include <Arduino.h>
+
+#define SIM_PINES 64
+
+// Tiempo simulado. Avanzar dispara el timer de hardware registrado (Patrones).
+void sim_reiniciarTiempo(unsigned long ms);
+void sim_avanzar(unsigned long ms);
+
+// Entradas (nivel eléctrico) y salidas
+void sim_fijarEntrada(uint8_t pin, int nivel);
+int  sim_salida(uint8_t pin);
+
+// Se llama en cada digitalWrite (para verificar invariantes en el instante)
+void sim_alEscribir(void (*fn)(uint8_t pin, uint8_t valor));
+
+// Contadores de E/S (costo determinístico por vuelta)
+struct ContadoresES {
+  uint32_t lecturas;
+  uint32_t escrituras;
+};
+ContadoresES sim_contadores();
+void sim_limpiarContadores();
+
+// Tareas creadas con xTaskCreatePinnedToCore (no se ejecutan solas)
+int sim_tareasCreadas();
+
+// Estado del WiFi que ven los módulos de red
+void sim_wifiConectado(bool conectado);
@@ -0,0 +1,38 @@
+#pragma once
+
+// =================================================================================
+// VERIFICACIÓN – contador de fallas y estado de main.cpp para los tests host
+// =================================================================================
+// VERIFICAR anota la falla y sigue: el test devuelve 'fallas' al terminar.
+//
+// Los tests de un módulo que NO incluyen main.cpp definen SIN_MAIN_CPP antes de
+// incluir este header: así se definen acá las variables globales que main.cpp
+// comparte con los módulos (extern) y registrarEvento(), que solo cuenta.
+// =================================================================================
+
+#include <Arduino.h>
+
+#include <atomic>
+#include <stdio.h>
+
+static int fallas = 0;
+
+#define VERIFICAR(cond, msg) \
+  do { if (!(cond)) { printf("FALLA: %s (linea %d)\n", msg, __LINE__); fallas++; } } while (0)
+
+#ifdef SIN_MAIN_CPP
+
+int  estadoPortonUI    = 1;
+int  estadoSeguridadUI = 0;
+char ultimoUsuario[20] = "Sistema";
+bool solicitudPulso    = false;
+bool panicoEnclavado   = false;
+bool emergenciaActiva  = false;
+bool modoMantenimiento = false;
+
+// Atómico: los módulos con tarea propia pueden registrar desde otro hilo
+static std::atomic<uint32_t> eventosRegistrados(0);
+
+void registrarEvento(String, String) { eventosRegistrados++; }
+
+#endif
@@ -0,0 +1,439 @@
+// =================================================================================
+// TEST DE PROPIEDADES – BLOQUES DE CONTROL DE main.cpp
+// =================================================================================
+// Maneja los bloques del loop(), en el mismo orden, con secuencias aleatorias de
+// entradas y tiempos (botones, RF, barrera, finales de carrera, comandos remotos,
+// obstrucciones por corriente de motor, vueltas lentas) sobre un modelo simple
+// del portón, y verifica en cada vuelta:
+//
+//   1. Nunca un flanco de subida del relé con barrera cortada y portón abierto
+//   2. Pánico enclavado ⇒ alarma disparada y sirena encendida; se libera solo
+//      al soltar una pulsación posterior; la pulsación que lo disparó no genera
+//      pulso
+//   3. Sabotaje (NORMAL → DISPARADA) solo con FC cerrado liberado hace > 4 s
+//
+// Uso:  test_control [secuencias] [semilla]
+// Se compila una vez por variante (PRODUCTO_RESIDENCIAL / PRODUCTO_BASICO): las
+// propiedades de funciones ausentes en la variante no se exigen.
+// Con -DFUZZ_CONTROL se compila como objetivo libFuzzer (los bytes de entrada
+// reemplazan al generador aleatorio).
+// =================================================================================
+
+#include "../CorrienteMotor.cpp"   // Acceso a la obstrucción para inyectarla
+#include "../main.cpp"
+#include "simulador.h"
+
+#include <random>
+#include <stdlib.h>
+
+// =================================================================================
+// 1. FUENTE DE DECISIONES
+// =================================================================================
+class Fuente {
+public:
+  explicit Fuente(uint32_t semilla) : rng(semilla) {}
+  Fuente(const uint8_t* d, size_t n) : rng(0), datos(d), largo(n), deBytes(true) {}
+
+  // Valor en [0, n)
+  uint32_t rango(uint32_t n) {
+    if (!deBytes) return rng() % n;
+    uint32_t v = 0;
+    for (int i = 0; i < 2 && largo > 0; i++, largo--) v = (v << 8) | *datos++;
+    return v % n;
+  }
+
+  bool probabilidad(uint32_t porMil) { return rango(1000) < porMil; }
+  bool agotada() const { return deBytes && largo == 0; }
+
+private:
+  std::mt19937 rng;
+  const uint8_t* datos = nullptr;
+  size_t largo = 0;
+  bool deBytes = false;
+};
+
+// =================================================================================
+// 2. MODELO DEL PORTÓN
+// =================================================================================
+#define RECORRIDO_MS 8000      // Viaje completo de un final al otro
+
+struct ModeloPorton {
+  long posicion;               // 0 = cerrado, RECORRIDO_MS = abierto
+  int  sentido;                // +1 abre, -1 cierra, 0 quieto
+  int  ultimoSentido;
+
+  void reiniciar() { posicion = 0; sentido = 0; ultimoSentido = -1; }
+
+  // La central alterna: quieto → se mueve al revés que la última vez; en
+  // movimiento → se detiene
+  void pulso() {
+    if (sentido != 0) {
+      sentido = 0;
+    } else {
+      sentido = -ultimoSentido;
+      ultimoSentido = sentido;
+    }
+  }
+
+  void avanzar(unsigned long ms) {
+    posicion += sentido * (long)ms;
+    if (posicion <= 0)           { posicion = 0;           sentido = 0; }
+    if (posicion >= RECORRIDO_MS) { posicion = RECORRIDO_MS; sentido = 0; }
+  }
+};
+
+// Falla inyectada sobre los finales de carrera
+enum FallaFC {
+  FC_SIN_FALLA,
+  FC_CERRADO_LIBERADO,         // Sabotaje: FC cerrado no se activa
+  FC_AMBOS,                    // Error de sensores
+  FC_RUIDO                     // Lecturas al azar
+};
+
+// =================================================================================
+// 3. ESTADO DEL HARNESS
+// =================================================================================
+static ModeloPorton modelo;
+
+static bool inManual  = false;
+static bool inRF      = false;
+static bool inProg    = false;
+static bool inBarrera = false;     // true = cortada
+static FallaFC falla  = FC_SIN_FALLA;
+
+static bool inFCCerrado = true;
+
+// FC cerrado tal como lo muestrea el loop(): un cierre más corto que una
+// vuelta no existe para el firmware
+static bool fcCerradoMuestreado = true;
+static unsigned long tFCLiberado = 0;
+
+static bool releAlto = false;
+
+// Pulsación de manual/RF tal como la muestrea el loop()
+static bool     botonMuestreado = false;
+static uint32_t idPulsacion     = 0;
+static uint32_t pulsacionPanico = 0;
+static unsigned long tInicioPulsacion = 0;
+
+static bool modoFuzz = false;
+static uint32_t semillaActual = 0;
+static uint32_t violaciones = 0;
+
+// Cobertura: si algo de esto queda en cero el test no probó nada
+static uint32_t cntPulsos     = 0;
+static uint32_t cntBloqueados = 0;
+static uint32_t cntPanicos    = 0;
+static uint32_t cntLiberados  = 0;
+static uint32_t cntSabotajes  = 0;
+static uint32_t cntBeepPanico = 0;
+static uint32_t cntObstrucciones = 0;   // Obstrucciones que pidieron pulso
+
+static void violacion(const char* regla) {
+  violaciones++;
+  if (violaciones <= 10) {
+    printf("VIOLACION [semilla %lu, t=%lu ms]: %s\n",
+           (unsigned long)semillaActual, millis(), regla);
+  }
+  if (modoFuzz) abort();
+}
+
+// =================================================================================
+// 4. ENTRADAS Y SALIDAS
+// =================================================================================
+static void aplicarEntradas(Fuente& f) {
+
+  bool fcCerrado = (modelo.posicion == 0);
+  bool fcAbierto = (modelo.posicion == RECORRIDO_MS);
+
+  switch (falla) {
+    case FC_CERRADO_LIBERADO: fcCerrado = false;                         break;
+    case FC_AMBOS:            fcCerrado = true; fcAbierto = true;        break;
+    case FC_RUIDO:            fcCerrado = f.probabilidad(500);
+                              fcAbierto = f.probabilidad(500);           break;
+    default:                                                             break;
+  }
+
+  inFCCerrado = fcCerrado;
+
+  // Entradas activas en LOW; barrera NC → HIGH = cortada
+  sim_fijarEntrada(PIN_FC_CERRADO, fcCerrado ? LOW : HIGH);
+  sim_fijarEntrada(PIN_FC_ABIERTO, fcAbierto ? LOW : HIGH);
+  sim_fijarEntrada(PIN_BTN_MANUAL, inManual ? LOW : HIGH);
+  sim_fijarEntrada(PIN_RF_RX,      inRF     ? LOW : HIGH);
+  sim_fijarEntrada(PIN_BTN_PROG,   inProg   ? LOW : HIGH);
+  sim_fijarEntrada(PIN_BARRERA,    inBarrera ? HIGH : LOW);
+}
+
+static void alEscribir(uint8_t pin, uint8_t valor) {
+
+  if (pin != PIN_RELE_PULSO) return;
+
+  bool flanco = (valor == HIGH && !releAlto);
+  releAlto = (valor == HIGH);
+  if (!flanco) return;
+
+  cntPulsos++;
+  modelo.pulso();
+
+  // ---- Invariante 1 ----
+  if (inBarrera && estadoPortonActual == ESTADO_ABIERTO) {
+    violacion("Pulso con barrera cortada y porton abierto");
+  }
+}
+
+// =================================================================================
+// 5. UNA VUELTA DEL LOOP
+// =================================================================================
+static void vuelta() {
+
+  unsigned long ahora = millis();
+
+  // ---- Pulsación vista por esta vuelta ----
+  bool boton   = inManual || inRF;
+  bool soltado = botonMuestreado && !boton;
+  if (boton && !botonMuestreado) {
+    idPulsacion++;
+    tInicioPulsacion = ahora;
+  }
+  botonMuestreado = boton;
+
+  if (fcCerradoMuestreado && !inFCCerrado) tFCLiberado = ahora;
+  fcCerradoMuestreado = inFCCerrado;
+
+  // --------------------------------------------------
+  // Entradas de usuario (pánico)
+  // --------------------------------------------------
+  bool pulsoAntes  = solicitudPulso;
+  bool panicoAntes = panicoEnclavado;
+
+  procesarEntradasUsuario();
+
+  if (!panicoAntes && panicoEnclavado) {
+    cntPanicos++;
+    pulsacionPanico = idPulsacion;
+    if (!inManual || ahora - tInicioPulsacion < TIEMPO_PANICO_MS) {
+      violacion("Panico sin mantener el boton manual");
+    }
+  }
+
+  if (panicoAntes && !panicoEnclavado) {
+    cntLiberados++;
+    if (!soltado || idPulsacion == pulsacionPanico) {
+      violacion("Panico liberado sin soltar una pulsacion posterior");
+    }
+  }
+
+  if (soltado && idPulsacion == pulsacionPanico && !pulsoAntes && solicitudPulso) {
+    violacion("Pulso generado por la pulsacion que disparo el panico");
+  }
+
+  // --------------------------------------------------
+  // Barrera, corriente de motor, estado, seguridad
+  // --------------------------------------------------
+  procesarBarrera();
+
+  if (PRODUCTO.corrienteMotor) {
+    bool inyectada = obstruccion;
+    procesarCorrienteMotor();
+    if (inyectada && solicitudPulso && strcmp(ultimoUsuario, "Sensores") == 0) cntObstrucciones++;
+  }
+
+  actualizarEstadoPorton();
+
+  EstadoSeguridad seguridadAntes = estadoSeguridad;
+  procesarSeguridad();
+
+  if (seguridadAntes == SEG_NORMAL && estadoSeguridad == SEG_DISPARADA) {
+    cntSabotajes++;
+    if (fcCerradoMuestreado || ahora - tFCLiberado <= 4000) {
+      violacion("Sabotaje disparado sin 4 s de FC cerrado liberado");
+    }
+  }
+
+  // --------------------------------------------------
+  // Actuadores
+  // --------------------------------------------------
+  bool pedido = solicitudPulso;
+  gestionarPulso();
+  if (pedido && !solicitudPulso && !releAlto && inBarrera &&
+      estadoPortonActual == ESTADO_ABIERTO) {
+    cntBloqueados++;
+  }
+
+  if (PRODUCTO.sirena)   gestionarSirena();
+  if (PRODUCTO.semaforo) gestionarSemaforo();
+  gestionarLedConfig();
+
+  if (panicoEnclavado) {
+    if (estadoSeguridad != SEG_DISPARADA) {
+      violacion("Panico enclavado sin alarma disparada");
+    }
+    if (PRODUCTO.sirena && sim_salida(PIN_SIRENA) != HIGH) {
+      violacion("Panico enclavado con sirena apagada");
+    }
+    if (estadoSirena == SIR_BEEP_ERROR) cntBeepPanico++;
+  }
+}
+
+// =================================================================================
+// 6. SECUENCIAS
+// =================================================================================
+static void avanzarTiempo(Fuente& f, unsigned long ms) {
+  sim_avanzar(ms);
+  modelo.avanzar(ms);
+  aplicarEntradas(f);
+}
+
+// Estado conocido: firmware recién arrancado y portón cerrado estable
+static void reiniciarFirmware(Fuente& f) {
+
+  modelo.reiniciar();
+  inManual = inRF = inProg = inBarrera = false;
+  falla = FC_SIN_FALLA;
+  aplicarEntradas(f);
+
+  panicoEnclavado = false;
+  panicoDisparadoEnEstaPulsacion = false;
+  botonPresionado = false;
+  progPresionado  = false;
+  nivelProg       = 0;
+  beepPendiente   = false;
+  ledConfigModo   = LEDCFG_IDLE;
+  botonMuestreado = false;
+
+  setup();
+
+  for (int i = 0; i < 700; i++) {
+    vuelta();
+    avanzarTiempo(f, 10);
+  }
+}
+
+static void correrSegmento(Fuente& f) {
+
+  // ---- Entradas del segmento ----
+  uint32_t r = f.rango(100);
+  inManual = (r < 25);
+  inRF     = (r >= 25 && r < 37);
+  inProg   = (r >= 37 && r < 40);
+
+  if (f.probabilidad(300)) inBarrera = !inBarrera;
+
+  if (f.probabilidad(100)) {
+    falla = (FallaFC)f.rango(4);
+  } else if (f.probabilidad(300)) {
+    falla = FC_SIN_FALLA;
+  }
+
+  // ---- Duración: corta, larga (pánico) o muy larga (viaje) ----
+  unsigned long duracion;
+  uint32_t d = f.rango(10);
+  if (d < 6)      duracion = 10 + f.rango(400);
+  else if (d < 9) duracion = 2500 + f.rango(2500);
+  else            duracion = 4000 + f.rango(8000);
+
+  // Reposo largo sin órdenes: el portón llega a cerrado estable y el FC
+  // cerrado puede liberarse (sabotaje)
+  bool reposo = f.probabilidad(150);
+  if (reposo) {
+    inManual = inRF = inProg = false;
+    duracion = 6000 + f.rango(8000);
+    if (f.probabilidad(400)) falla = FC_CERRADO_LIBERADO;
+  }
+
+  unsigned long periodo = 1 + f.rango(25);
+  aplicarEntradas(f);
+
+  unsigned long fin = millis() + duracion;
+  while (millis() < fin) {
+
+    // Comando remoto (WebUI / UDP / MQTT)
+    if (!reposo && f.probabilidad(2)) solicitudPulso = true;
+
+    // Obstrucción detectada por la tarea de corriente: sobre todo en
+    // movimiento, a veces justo al llegar al final (bandera pendiente)
+    if (PRODUCTO.corrienteMotor && f.probabilidad(enMovimiento ? 3 : 1)) {
+      portENTER_CRITICAL(&muxCorriente);
+      obstruccion = true;
+      portEXIT_CRITICAL(&muxCorriente);
+    }
+
+    vuelta();
+
+    // Vuelta lenta ocasional (WiFi / flash)
+    unsigned long paso = f.probabilidad(10) ? 100 + f.rango(200) : periodo;
+    avanzarTiempo(f, paso);
+
+    if (f.agotada()) return;
+  }
+}
+
+static void correrSecuencia(Fuente& f, int segmentos) {
+  reiniciarFirmware(f);
+  for (int i = 0; (segmentos == 0 || i < segmentos) && !f.agotada(); i++) {
+    correrSegmento(f);
+  }
+}
+
+static void iniciarHarness() {
+  sim_reiniciarTiempo(1000);
+  sim_alEscribir(alEscribir);
+}
+
+// =================================================================================
+// 7. PUNTO DE ENTRADA
+// =================================================================================
+#ifdef FUZZ_CONTROL
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* datos, size_t largo) {
+  static bool iniciado = false;
+  if (!iniciado) {
+    iniciarHarness();
+    modoFuzz = true;
+    iniciado = true;
+  }
+  Fuente f(datos, largo);
+  correrSecuencia(f, 0);
+  return 0;
+}
+
+#else
+
+int main(int argc, char** argv) {
+
+  int secuencias    = (argc > 1) ? atoi(argv[1]) : 200;
+  uint32_t semilla0 = (argc > 2) ? (uint32_t)strtoul(argv[2], nullptr, 10) : 1;
+
+  iniciarHarness();
+
+  for (int s = 0; s < secuencias; s++) {
+    semillaActual = semilla0 + s;
+    Fuente f(semillaActual);
+    correrSecuencia(f, 120);
+  }
+
+  printf("secuencias=%d pulsos=%lu bloqueados=%lu panicos=%lu liberados=%lu "
+         "sabotajes=%lu beepEnPanico=%lu obstrucciones=%lu violaciones=%lu\n",
+         secuencias, (unsigned long)cntPulsos, (unsigned long)cntBloqueados,
+         (unsigned long)cntPanicos, (unsigned long)cntLiberados,
+         (unsigned long)cntSabotajes, (unsigned long)cntBeepPanico,
+         (unsigned long)cntObstrucciones, (unsigned long)violaciones);
+
+  if (violaciones > 0) return 1;
+
+  // Sin cobertura de cada propiedad el resultado no prueba nada. Solo se exige
+  // lo que la variante compilada (PRODUCTO) puede producir.
+  bool cubierto = cntPulsos && cntBloqueados;
+  if (PRODUCTO.panico)         cubierto = cubierto && cntPanicos && cntLiberados;
+  if (PRODUCTO.sabotaje)       cubierto = cubierto && cntSabotajes;
+  if (PRODUCTO.corrienteMotor) cubierto = cubierto && cntObstrucciones;
+
+  if (!cubierto) {
+    printf("COBERTURA INSUFICIENTE\n");
+    return 1;
+  }
+  return 0;
+}
+
+#endif
@@ -0,0 +1,224 @@
+// =================================================================================
+// TEST – APRENDIZAJE Y DETECCIÓN DE CORRIENTE DE MOTOR
+// =================================================================================
+// Alimenta procesarBloque() con un perfil de corriente dependiente de la posición
+// (arranque, zona pesada a mitad de recorrido, frenado) y verifica la secuencia:
+//
+//   1. Viaje 1: solo se aprende el tiempo de viaje (envolvente intacta)
+//   2. Viaje 2: envolvente por tramo (no todo en el último tramo)
+//   3. Hasta CORRIENTE_CORRIDAS_APRENDIZAJE viajes no se arma
+//   4. Viajes normales con algo de variación: sin falsas detecciones
+//   5. Un pico sostenido se detecta rápido y esa corrida no se aprende
+//   6. Una corrida no aprendible (comando a mitad de viaje) no cambia el perfil
+//   7. Tras un reinicio los perfiles vuelven de NVS ya armados
+//   8. Viajes de aprendizaje de distinta duración (más cortos o más largos que
+//      el primero): ningún tramo queda sin aprender ni se apila al final
+//   9. procesarCorrienteMotor() (main.cpp): un comando a mitad de viaje rearma
+//      sin aprender; el pulso de inversión de Sensores desarma hasta el próximo
+//      cambio de estado
+// =================================================================================
+
+#include "../CorrienteMotor.cpp"
+#include "../main.cpp"
+#include "simulador.h"
+#include "verificacion.h"
+
+#define VIAJE_MS   12000
+#define BLOQUE_MS  13        // 256 muestras a 20 kHz
+
+// Corriente (cuentas ADC) según la fracción recorrida
+static uint16_t perfilCorriente(double x, double escala) {
+  double v;
+  if (x < 0.03)      v = 1400;                      // Arranque
+  else if (x < 0.40) v = 500;
+  else if (x < 0.60) v = 800;                       // Zona pesada
+  else               v = 550;
+  return (uint16_t)(v * escala);
+}
+
+// Un viaje completo. Devuelve ms desde el inicio del pico hasta la detección
+// (-1 = sin detección). 'picoDesde' < 0 = sin obstrucción.
+static long viaje(SentidoMotor sentido, unsigned long duracion, double escala,
+                  double picoDesde = -1, bool aprendible = true) {
+
+  CorrienteMotor_inicioMovimiento(sentido, aprendible);
+  long detectado = -1;
+
+  for (unsigned long t = 0; t < duracion; t += BLOQUE_MS) {
+    sim_avanzar(BLOQUE_MS);
+    double x = (double)t / duracion;
+    uint16_t v = perfilCorriente(x, escala);
+    if (picoDesde >= 0 && x >= picoDesde) v += 700;
+    procesarBloque(v);
+
+    if (CorrienteMotor_obstruccion() && detectado < 0) {
+      detectado = (long)(t - (unsigned long)(picoDesde * duracion));
+      break;    // El loop() invierte el portón
+    }
+  }
+
+  CorrienteMotor_finMovimiento(detectado < 0);
+
+  // Motor detenido: un bloque en reposo procesa el fin de corrida
+  sim_avanzar(BLOQUE_MS);
+  procesarBloque(20);
+  return detectado;
+}
+
+// Un pulso autorizado completo (relé activado y liberado)
+static void pulso(const char* usuario) {
+  sim_avanzar(SEPARACION_PULSOS_MS);
+  strcpy(ultimoUsuario, usuario);
+  solicitudPulso = true;
+  gestionarPulso();
+  sim_avanzar(DURACION_PULSO_MS);
+  gestionarPulso();
+}
+
+static void pruebaLoop() {
+
+  // ---- Cierre normal: corrida aprendible ----
+  estadoPortonActual = ESTADO_CERRANDO;
+  procesarCorrienteMotor();
+  uint32_t id = idCorrida;
+  VERIFICAR(enMovimiento && sentidoActual == MOTOR_CERRANDO && aprendible, "inicio de cierre");
+
+  // ---- Comando de usuario a mitad de viaje: rearma sin aprender ----
+  pulso("Web Admin");
+  procesarCorrienteMotor();
+  VERIFICAR(idCorrida == id + 1 && enMovimiento && !aprendible, "comando a mitad de viaje no rearma");
+  id = idCorrida;
+
+  // ---- Obstrucción: el pulso de inversión no rearma ----
+  obstruccion = true;
+  procesarCorrienteMotor();
+  VERIFICAR(solicitudPulso && strcmp(ultimoUsuario, "Sensores") == 0, "obstruccion sin pulso");
+  gestionarPulso();
+  sim_avanzar(DURACION_PULSO_MS);
+  gestionarPulso();
+  procesarCorrienteMotor();
+  VERIFICAR(idCorrida == id && !enMovimiento, "pulso de Sensores rearmo la deteccion");
+
+  // Sigue desarmado con otros comandos mientras el estado no cambie
+  pulso("Web Admin");
+  procesarCorrienteMotor();
+  VERIFICAR(idCorrida == id && !enMovimiento, "rearmado sin cambio de estado");
+
+  // ---- El estado informa el final de carrera y un nuevo viaje: se arma ----
+  estadoPortonActual = ESTADO_ABIERTO;
+  procesarCorrienteMotor();
+  estadoPortonActual = ESTADO_CERRANDO;
+  procesarCorrienteMotor();
+  VERIFICAR(idCorrida == id + 1 && enMovimiento && aprendible, "no se armo en el nuevo viaje");
+  id = idCorrida;
+
+  // ---- Barrera durante el cierre: tampoco rearma ----
+  sim_avanzar(SEPARACION_PULSOS_MS);
+  sim_fijarEntrada(PIN_BARRERA, HIGH);
+  procesarBarrera();
+  gestionarPulso();
+  sim_fijarEntrada(PIN_BARRERA, LOW);
+  sim_avanzar(DURACION_PULSO_MS);
+  gestionarPulso();
+  procesarCorrienteMotor();
+  VERIFICAR(idCorrida == id && !enMovimiento, "pulso de barrera rearmo la deteccion");
+}
+
+int main() {
+
+  sim_reiniciarTiempo(1000);
+  CorrienteMotor_begin();
+
+  PerfilSentido& p = perfiles[MOTOR_ABRIENDO];
+
+  // ---- 1. Primer viaje: solo duración ----
+  VERIFICAR(viaje(MOTOR_ABRIENDO, VIAJE_MS, 1.0) < 0, "deteccion sin aprender");
+  VERIFICAR(p.corridas == 1, "primer viaje no contado");
+  VERIFICAR(p.tiempoViajeMs >= VIAJE_MS - 50 && p.tiempoViajeMs <= VIAJE_MS + 50,
+            "tiempo de viaje del primer viaje");
+  uint16_t maxEnv = 0;
+  for (uint8_t i = 0; i < CORRIENTE_TRAMOS; i++) maxEnv = max(maxEnv, p.envolvente[i]);
+  VERIFICAR(maxEnv == 0, "envolvente aprendida sin tiempo de viaje");
+
+  // ---- 2. Segundo viaje: envolvente por posición ----
+  VERIFICAR(viaje(MOTOR_ABRIENDO, VIAJE_MS, 1.0) < 0, "deteccion en el segundo viaje");
+  VERIFICAR(p.corridas == 2, "segundo viaje no contado");
+  uint16_t medio = p.envolvente[CORRIENTE_TRAMOS / 2];
+  uint16_t cuarto = p.envolvente[CORRIENTE_TRAMOS / 4];
+  VERIFICAR(medio >= 750 && medio <= 850, "envolvente de la zona pesada");
+  VERIFICAR(cuarto >= 450 && cuarto <= 550, "envolvente de la zona liviana");
+  VERIFICAR(p.envolvente[CORRIENTE_TRAMOS - 1] < 700, "todo acumulado en el ultimo tramo");
+  VERIFICAR(!perfilListo(p), "armado antes de tiempo");
+
+  // ---- 3. Tercer viaje: queda listo ----
+  VERIFICAR(viaje(MOTOR_ABRIENDO, VIAJE_MS, 1.0) < 0, "deteccion en el tercer viaje");
+  VERIFICAR(perfilListo(p), "no se armo tras el aprendizaje");
+
+  // ---- 4. Viajes normales con variación: sin falsas detecciones ----
+  const double escalas[]   = { 1.00, 1.08, 0.95, 1.05, 0.92 };
+  const long   duraciones[] = { VIAJE_MS, VIAJE_MS + 400, VIAJE_MS - 300, VIAJE_MS + 200, VIAJE_MS };
+  for (int i = 0; i < 5; i++) {
+    VERIFICAR(viaje(MOTOR_ABRIENDO, duraciones[i], escalas[i]) < 0, "falsa deteccion en viaje normal");
+  }
+
+  // El otro sentido sigue sin aprender
+  VERIFICAR(perfiles[MOTOR_CERRANDO].corridas == 0, "aprendizaje mezclado entre sentidos");
+
+  // ---- 5. Obstrucción ----
+  uint8_t corridasAntes = p.corridas;
+  long demora = viaje(MOTOR_ABRIENDO, VIAJE_MS, 1.0, 0.25);
+  printf("corriente: obstruccion detectada en %ld ms\n", demora);
+  VERIFICAR(demora >= 0 && demora <= 150, "obstruccion no detectada a tiempo");
+  VERIFICAR(p.corridas == corridasAntes, "corrida obstruida aprendida");
+
+  // ---- 6. Corrida no aprendible: detecta pero no aprende ----
+  PerfilSentido antes = p;
+  uint32_t escriturasAntes = Preferences::escrituras();
+  VERIFICAR(viaje(MOTOR_ABRIENDO, VIAJE_MS, 1.0, -1, false) < 0, "falsa deteccion sin aprender");
+  VERIFICAR(memcmp(&antes, &p, sizeof(p)) == 0, "corrida no aprendible aprendida");
+  VERIFICAR(Preferences::escrituras() == escriturasAntes, "escritura en NVS sin aprender");
+  demora = viaje(MOTOR_ABRIENDO, VIAJE_MS, 1.0, 0.5, false);
+  VERIFICAR(demora >= 0 && demora <= 150, "corrida no aprendible sin deteccion");
+
+  // ---- 7. Reinicio: perfiles desde NVS ----
+  VERIFICAR(Preferences::escrituras() >= 8, "perfiles no guardados");
+  memset(perfiles, 0, sizeof(perfiles));
+  CorrienteMotor_begin();
+  VERIFICAR(memcmp(&antes, &p, sizeof(p)) == 0, "perfiles no restaurados");
+  VERIFICAR(perfilListo(p), "no armado tras el reinicio");
+  demora = viaje(MOTOR_ABRIENDO, VIAJE_MS, 1.0, 0.75);
+  VERIFICAR(demora >= 0 && demora <= 150, "sin deteccion tras el reinicio");
+
+  // ---- 8. Aprendizaje con duraciones distintas ----
+  const long secuencias[][3] = {
+    { VIAJE_MS, VIAJE_MS - 500, VIAJE_MS },         // 2º viaje más corto
+    { VIAJE_MS, VIAJE_MS + 1000, VIAJE_MS },        // 2º viaje más largo
+    { VIAJE_MS, VIAJE_MS - 700, VIAJE_MS - 700 },
+  };
+  PerfilSentido& c = perfiles[MOTOR_CERRANDO];
+
+  for (auto& sec : secuencias) {
+    memset(&c, 0, sizeof(c));
+    for (long d : sec) VERIFICAR(viaje(MOTOR_CERRANDO, d, 1.0) < 0, "deteccion aprendiendo");
+    VERIFICAR(perfilListo(c), "no armado tras duraciones distintas");
+
+    uint16_t minimo = 0xFFFF, maximo = 0;
+    for (uint8_t i = CORRIENTE_TRAMOS / 8; i < CORRIENTE_TRAMOS; i++) {
+      minimo = min(minimo, c.envolvente[i]);
+      maximo = max(maximo, c.envolvente[i]);
+    }
+    VERIFICAR(minimo >= 450, "tramo sin aprender");
+    VERIFICAR(maximo <= 850, "tramo inflado");
+    VERIFICAR(c.envolvente[CORRIENTE_TRAMOS - 1] >= 500 &&
+              c.envolvente[CORRIENTE_TRAMOS - 1] <= 600, "ultimo tramo mal aprendido");
+
+    for (int i = 0; i < 5; i++) {
+      VERIFICAR(viaje(MOTOR_CERRANDO, sec[2], 1.0) < 0, "falsa deteccion al final del viaje");
+    }
+  }
+
+  pruebaLoop();
+
+  printf("corriente: %d fallas\n", fallas);
+  return fallas ? 1 : 0;
+}
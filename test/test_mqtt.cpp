@@ -0,0 +1,397 @@
+// =================================================================================
+// TEST – PUENTE MQTT CONTRA UN BROKER SIMULADO
+// =================================================================================
+// Compila el PuenteMQTT.cpp real contra el shim de PubSubClient (broker en
+// memoria, ver shims/PubSubClient.h):
+//
+//   1. Funcional (tarea ejecutada vuelta a vuelta con cicloMQTT()):
+//      conexión, borrado del comando retenido, comandos con sesión / secuencia,
+//      coalescencia del estado, lotes, cola con descarte del más viejo y
+//      reintento de un lote rechazado.
+//   2. Carga: la tarea corre en un hilo contra un broker lento mientras el
+//      "loop()" publica eventos y cambia el estado. Se mide mensajes/s, eventos/s
+//      y el costo por vuelta del lado del loop() (jitter que agrega el puente).
+//
+// Falla si no se cumplen los umbrales de la sección 1.
+// =================================================================================
+
+#define MQTT_HOST "broker.test"
+#define MQTT_ID   "p1"
+
+#define SIN_MAIN_CPP
+
+#include "../PuenteMQTT.cpp"
+#include "simulador.h"
+#include "verificacion.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// =================================================================================
+// 1. UMBRALES
+// =================================================================================
+#define DEMORA_BROKER_US        1000    // Latencia por publicación del broker lento
+#define VUELTAS_CARGA           1500    // Vueltas de 1 ms del loop() por fase
+#define EVENTOS_CADA_NOMINAL    5       // 200 eventos/s: no debe perderse ninguno
+#define EVENTOS_CADA_SATURADO   1       // 1000 eventos/s: descarte contabilizado
+#define MIN_EVENTOS_POR_SEG     200     // Saturado: capacidad de la tarea
+#define MAX_LOOP_P99_NS         20000   // PuenteMQTT_loop() + publicarEvento()
+
+// =================================================================================
+// 2. HELPERS
+// =================================================================================
+static BrokerSimulado& broker = BrokerSimulado::instancia();
+
+static const std::string T_ESTADO   = "portones/p1/estado";
+static const std::string T_EVENTOS  = "portones/p1/eventos";
+static const std::string T_CONEXION = "portones/p1/conexion";
+static const std::string T_CMD      = "portones/p1/cmd";
+static const std::string T_ACK      = "portones/p1/cmd/ack";
+
+static std::vector<MensajeMQTT> publicadosEn(const std::string& topic) {
+  std::vector<MensajeMQTT> r;
+  for (auto& m : broker.publicados()) if (m.topic == topic) r.push_back(m);
+  return r;
+}
+
+static int contar(const std::string& s, const char* patron) {
+  int n = 0;
+  for (size_t p = s.find(patron); p != std::string::npos; p = s.find(patron, p + 1)) n++;
+  return n;
+}
+
+static unsigned long campo(const std::string& json, const char* nombre) {
+  std::string clave = std::string("\"") + nombre + "\":";
+  size_t p = json.find(clave);
+  return p == std::string::npos ? 0 : strtoul(json.c_str() + p + clave.size(), nullptr, 10);
+}
+
+// Una vuelta del loop() y una de la tarea
+static void vuelta(unsigned long ms = MQTT_PERIODO_TAREA_MS) {
+  PuenteMQTT_loop();
+  cicloMQTT();
+  sim_avanzar(ms);
+}
+
+static std::string sesionHex() {
+  char s[12];
+  snprintf(s, sizeof(s), "%08lx", (unsigned long)sesion);
+  return s;
+}
+
+// Publica un comando y devuelve el resultado del ack ("" = sin ack)
+static std::string comando(const std::string& texto) {
+  broker.limpiarPublicados();
+  broker.inyectar(T_CMD, texto, false);
+  vuelta();
+  PuenteMQTT_loop();                    // Toma el comando aceptado
+  auto acks = publicadosEn(T_ACK);
+  if (acks.size() != 1) return "";
+  size_t p = acks[0].payload.find("\"resultado\":\"");
+  if (p == std::string::npos) return "?";
+  p += 13;
+  return acks[0].payload.substr(p, acks[0].payload.find('"', p) - p);
+}
+
+// Eventos entregados y descartados informados en los lotes publicados
+static void contarLotes(int& entregados, unsigned long& descartados) {
+  entregados = 0;
+  descartados = 0;
+  for (auto& m : publicadosEn(T_EVENTOS)) {
+    entregados  += contar(m.payload, "\"msg\"");
+    descartados += campo(m.payload, "descartados");
+  }
+}
+
+// =================================================================================
+// 3. FUNCIONAL
+// =================================================================================
+static void pruebaConexion() {
+
+  // Un comando retenido (p. ej. publicado con retain por error) no debe
+  // ejecutarse al conectar, aunque traiga la sesión y secuencia correctas
+  broker.inyectar(T_CMD, "PULSO " + sesionHex() + " 1", true);
+
+  sim_wifiConectado(false);
+  vuelta();
+  VERIFICAR(!broker.estaConectado(), "conecto sin WiFi");
+
+  sim_wifiConectado(true);
+  vuelta();
+  vuelta();
+  VERIFICAR(broker.estaConectado(), "no conecto");
+
+  std::string online;
+  VERIFICAR(broker.retenido(T_CONEXION, &online) && online == "online", "sin online retenido");
+  VERIFICAR(!broker.retenido(T_CMD), "comando retenido no borrado");
+  VERIFICAR(!comandoPulso && !solicitudPulso, "pulso por comando retenido");
+
+  auto estados = publicadosEn(T_ESTADO);
+  VERIFICAR(estados.size() == 1 && estados[0].retenido, "estado inicial no publicado");
+  VERIFICAR(!estados.empty() && estados[0].payload.find("\"sesion\":\"" + sesionHex() + "\"") !=
+            std::string::npos, "estado sin sesion");
+}
+
+static void pruebaComandos() {
+
+  std::string s = sesionHex();
+
+  VERIFICAR(comando("PULSO") == "invalido", "formato viejo aceptado");
+  char ajena[12];
+  snprintf(ajena, sizeof(ajena), "%08lx", (unsigned long)(sesion + 1));
+  VERIFICAR(comando(std::string("PULSO ") + ajena + " 1") == "sesion", "sesion ajena aceptada");
+  VERIFICAR(!solicitudPulso, "pulso con sesion ajena");
+
+  uint32_t previos = eventosRegistrados;
+  VERIFICAR(comando("PULSO " + s + " 5") == "aceptado", "comando valido rechazado");
+  VERIFICAR(solicitudPulso && eventosRegistrados == previos + 1, "comando aceptado sin pulso");
+  VERIFICAR(strcmp(ultimoUsuario, "MQTT") == 0, "usuario del comando");
+
+  // El estado informa la última secuencia aceptada
+  vuelta();
+  auto estados = publicadosEn(T_ESTADO);
+  VERIFICAR(!estados.empty() && campo(estados.back().payload, "secuencia") == 5,
+            "estado sin la secuencia aceptada");
+
+  solicitudPulso = false;
+  VERIFICAR(comando("PULSO " + s + " 5") == "duplicado", "duplicado no detectado");
+  VERIFICAR(comando("PULSO " + s + " 4") == "viejo", "secuencia vieja aceptada");
+  VERIFICAR(comando("ABRIR " + s + " 6") == "desconocido", "comando desconocido aceptado");
+  VERIFICAR(comando(std::string(60, 'P')) == "invalido", "comando largo aceptado");
+  VERIFICAR(!solicitudPulso, "pulso por comando rechazado");
+
+  // Reconexión: una nueva entrega del mismo comando es un duplicado
+  broker.desconectar();
+  sim_avanzar(MQTT_REINTENTO_MS);
+  vuelta();
+  VERIFICAR(broker.estaConectado(), "no reconecto");
+  VERIFICAR(comando("PULSO " + s + " 5") == "duplicado", "comando repetido tras reconectar");
+  VERIFICAR(comando("PULSO " + s + " 6") == "aceptado", "secuencia siguiente rechazada");
+  solicitudPulso = false;
+}
+
+static void pruebaCoalescencia() {
+
+  vuelta();
+  broker.limpiarPublicados();
+
+  // Varios cambios entre dos vueltas de la tarea: un solo estado, el último
+  for (int i = 0; i < 5; i++) {
+    estadoPortonUI = 10 + i;
+    PuenteMQTT_loop();
+  }
+  cicloMQTT();
+  vuelta();
+
+  auto estados = publicadosEn(T_ESTADO);
+  VERIFICAR(estados.size() == 1, "estado no coalescido");
+  VERIFICAR(!estados.empty() && campo(estados[0].payload, "porton") == 14, "estado no es el ultimo");
+
+  // Sin cambios no se publica nada
+  broker.limpiarPublicados();
+  for (int i = 0; i < 10; i++) vuelta();
+  VERIFICAR(publicadosEn(T_ESTADO).empty(), "estado publicado sin cambios");
+}
+
+static void pruebaLotes() {
+
+  broker.limpiarPublicados();
+
+  // Pocos eventos: se juntan hasta MQTT_PERIODO_LOTE_MS
+  for (int i = 0; i < 3; i++) PuenteMQTT_publicarEvento("evento", "test");
+  vuelta();
+  VERIFICAR(publicadosEn(T_EVENTOS).empty(), "lote enviado antes del periodo");
+  for (int i = 0; i < MQTT_PERIODO_LOTE_MS / MQTT_PERIODO_TAREA_MS + 1; i++) vuelta();
+  auto lotes = publicadosEn(T_EVENTOS);
+  VERIFICAR(lotes.size() == 1 && contar(lotes[0].payload, "\"msg\"") == 3, "lote de 3 eventos");
+
+  // Lote lleno: sale en la misma vuelta
+  broker.limpiarPublicados();
+  for (int i = 0; i < MQTT_EVENTOS_POR_LOTE; i++) PuenteMQTT_publicarEvento("lleno", "test");
+  vuelta();
+  lotes = publicadosEn(T_EVENTOS);
+  VERIFICAR(lotes.size() == 1 && contar(lotes[0].payload, "\"msg\"") == MQTT_EVENTOS_POR_LOTE,
+            "lote lleno no enviado de inmediato");
+
+  // Texto con comillas y barras: JSON escapado
+  broker.limpiarPublicados();
+  PuenteMQTT_publicarEvento("a \"b\" \\c", "u\"1");
+  for (int i = 0; i < MQTT_PERIODO_LOTE_MS / MQTT_PERIODO_TAREA_MS + 2; i++) vuelta();
+  lotes = publicadosEn(T_EVENTOS);
+  VERIFICAR(lotes.size() == 1 &&
+            lotes[0].payload.find("\"msg\":\"a \\\"b\\\" \\\\c\"") != std::string::npos &&
+            lotes[0].payload.find("\"usuario\":\"u\\\"1\"") != std::string::npos,
+            "JSON mal escapado");
+}
+
+static void pruebaContrapresion() {
+
+  // Broker caído: la cola se llena y descarta los más viejos
+  broker.desconectar();
+  broker.disponible = false;
+  broker.limpiarPublicados();
+  uint32_t descartadosAntes = PuenteMQTT_eventosDescartados();
+
+  const int producidos = MQTT_CAPACIDAD_COLA + 4;
+  for (int i = 0; i < producidos; i++) {
+    char msg[16];
+    snprintf(msg, sizeof(msg), "e%d", i);
+    PuenteMQTT_publicarEvento(msg, "test");
+    vuelta();
+  }
+  VERIFICAR(PuenteMQTT_eventosDescartados() - descartadosAntes == 4, "descarte mal contado");
+
+  // Vuelve el broker: se vacía la cola, informando lo perdido
+  broker.disponible = true;
+  sim_avanzar(MQTT_REINTENTO_MS);
+  for (int i = 0; i < 50; i++) vuelta();
+
+  int entregados;
+  unsigned long descartados;
+  contarLotes(entregados, descartados);
+  auto lotes = publicadosEn(T_EVENTOS);
+
+  VERIFICAR(entregados == MQTT_CAPACIDAD_COLA, "cola no vaciada al reconectar");
+  VERIFICAR(descartados == 4, "lote sin los descartados");
+  VERIFICAR(!lotes.empty() && lotes[0].payload.find("\"msg\":\"e4\"") != std::string::npos &&
+            lotes[0].payload.find("\"msg\":\"e3\"") == std::string::npos,
+            "no se descarto el mas viejo");
+  VERIFICAR(publicadosEn(T_ESTADO).size() == 1, "estado no republicado al reconectar");
+
+  // Publicación rechazada: el lote se reintenta sin duplicar ni perder
+  broker.limpiarPublicados();
+  broker.fallaPublicar = true;
+  for (int i = 0; i < 5; i++) PuenteMQTT_publicarEvento("reintento", "test");
+  for (int i = 0; i < 30; i++) vuelta();
+  broker.fallaPublicar = false;
+  for (int i = 0; i < 30; i++) vuelta();
+  contarLotes(entregados, descartados);
+  VERIFICAR(entregados == 5 && descartados == 0, "lote rechazado perdido o duplicado");
+}
+
+// =================================================================================
+// 4. CARGA
+// =================================================================================
+static std::atomic<bool> correr(false);
+
+static void hiloTarea() {
+  while (correr) {
+    vTaskDelay(pdMS_TO_TICKS(MQTT_PERIODO_TAREA_MS));
+    cicloMQTT();
+  }
+}
+
+struct ResultadoCarga {
+  int producidos;
+  int entregados;
+  unsigned long descartados;
+  double segundos;
+  size_t mensajes;
+  double p50, p99, maximo;     // ns por vuelta del lado del loop()
+};
+
+static ResultadoCarga fase(int eventosCada) {
+
+  using namespace std::chrono;
+
+  broker.limpiarPublicados();
+  std::vector<double> costos;
+  costos.reserve(VUELTAS_CARGA);
+  ResultadoCarga r = {};
+
+  correr = true;
+  std::thread tarea(hiloTarea);
+  auto inicio = steady_clock::now();
+
+  for (int i = 0; i < VUELTAS_CARGA; i++) {
+
+    auto t0 = steady_clock::now();
+    if (i % eventosCada == 0) {
+      PuenteMQTT_publicarEvento("Evento de carga", "test");
+      r.producidos++;
+    }
+    if (i % 50 == 0) estadoPortonUI = (estadoPortonUI % 6) + 1;
+    PuenteMQTT_loop();
+    costos.push_back((double)duration_cast<nanoseconds>(steady_clock::now() - t0).count());
+
+    sim_avanzar(1);
+    std::this_thread::sleep_for(milliseconds(1));
+  }
+
+  // Se deja terminar lo encolado
+  for (int i = 0; i < 200; i++) {
+    sim_avanzar(5);
+    std::this_thread::sleep_for(milliseconds(5));
+    portENTER_CRITICAL(&muxMQTT);
+    bool vacio = colaCantidad == 0;
+    portEXIT_CRITICAL(&muxMQTT);
+    if (vacio && loteCantidad == 0) break;
+  }
+  std::this_thread::sleep_for(milliseconds(3 * MQTT_PERIODO_TAREA_MS));
+
+  correr = false;
+  tarea.join();
+  r.segundos = duration_cast<microseconds>(steady_clock::now() - inicio).count() / 1e6;
+
+  contarLotes(r.entregados, r.descartados);
+  r.mensajes = broker.publicados().size();
+
+  std::sort(costos.begin(), costos.end());
+  r.p50    = costos[costos.size() / 2];
+  r.p99    = costos[(size_t)(costos.size() * 0.99)];
+  r.maximo = costos.back();
+  return r;
+}
+
+static void imprimir(const char* nombre, const ResultadoCarga& r) {
+  printf("%-9s %d producidos, %d entregados, %lu descartados | %.0f mensajes/s, %.0f eventos/s\n",
+         nombre, r.producidos, r.entregados, r.descartados,
+         r.mensajes / r.segundos, r.entregados / r.segundos);
+  printf("          loop(): p50=%.0f ns p99=%.0f ns max=%.0f ns (jitter p99-p50=%.0f ns)\n",
+         r.p50, r.p99, r.maximo, r.p99 - r.p50);
+}
+
+static void pruebaCarga() {
+
+  broker.demoraUs = DEMORA_BROKER_US;
+
+  // ---- Carga nominal: nada se pierde ----
+  ResultadoCarga nominal = fase(EVENTOS_CADA_NOMINAL);
+  imprimir("nominal", nominal);
+  VERIFICAR(nominal.entregados == nominal.producidos && nominal.descartados == 0,
+            "eventos perdidos con carga nominal");
+  VERIFICAR(nominal.p99 <= MAX_LOOP_P99_NS, "p99 del loop() sobre el umbral (nominal)");
+
+  // ---- Saturado: el loop() no espera y todo lo perdido se informa ----
+  ResultadoCarga saturado = fase(EVENTOS_CADA_SATURADO);
+  imprimir("saturado", saturado);
+  VERIFICAR(saturado.descartados > 0, "saturacion sin descarte");
+  VERIFICAR(saturado.entregados / saturado.segundos >= MIN_EVENTOS_POR_SEG, "eventos/s bajo el umbral");
+  VERIFICAR(saturado.entregados + (int)saturado.descartados == saturado.producidos,
+            "eventos sin contabilizar");
+  VERIFICAR(saturado.p99 <= MAX_LOOP_P99_NS, "p99 del loop() sobre el umbral (saturado)");
+
+  broker.demoraUs = 0;
+}
+
+// =================================================================================
+// 5. MAIN
+// =================================================================================
+int main() {
+
+  sim_reiniciarTiempo(1000);
+  PuenteMQTT_begin();
+  VERIFICAR(sim_tareasCreadas() == 1, "tarea MQTT no creada");
+
+  pruebaConexion();
+  pruebaComandos();
+  pruebaCoalescencia();
+  pruebaLotes();
+  pruebaContrapresion();
+  pruebaCarga();
+
+  printf("mqtt: %d fallas\n", fallas);
+  return fallas ? 1 : 0;
+}
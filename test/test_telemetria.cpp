@@ -0,0 +1,281 @@
+// =================================================================================
+// TEST – TELEMETRÍA: CONSOLIDACIÓN, EXPORTACIÓN Y PERSISTENCIA
+// =================================================================================
+// Consolidación (tiempo simulado, minuto a minuto):
+//   - Minuto → hora → día con ciclos / alarmas sumados y viaje / loop mín-prom-máx
+//   - Vuelta de los tres archivos circulares (60 min, 48 h, 31 días)
+//   - CSV y binario con 'maxMuestras', incluido el binario en dos tramos
+//
+// Reinicios simulados con el NVS en memoria del shim de Preferences:
+//   - El primer cambio se guarda enseguida; luego como mucho uno cada 30 s
+//   - Tras un reinicio los totales nunca retroceden más allá del último
+//     checkpoint (ni por debajo del RRD horario)
+//   - Telemetria_loop() no escribe en flash: solo deja la copia para la tarea
+// =================================================================================
+
+#include "../Telemetria.cpp"
+#include "Preferences.h"
+#include "simulador.h"
+#include "verificacion.h"
+
+#include <string>
+#include <vector>
+
+// Avanza el tiempo corriendo Telemetria_loop() cada 10 ms y, en cada vuelta, el
+// cuerpo de la tarea de guardado (en la placa corre sola en el core 0)
+static void correr(unsigned long ms) {
+  for (unsigned long t = 0; t < ms; t += 10) {
+    sim_avanzar(10);
+    Telemetria_loop();
+    guardarPendientes();
+  }
+}
+
+// =================================================================================
+// CONSOLIDACIÓN Y EXPORTACIÓN
+// =================================================================================
+struct Captura : public Print {
+  std::string datos;
+  size_t write(uint8_t c) override { datos += (char)c; return 1; }
+  size_t write(const uint8_t* b, size_t n) override { datos.append((const char*)b, n); return n; }
+};
+
+// Arranque en limpio (NVS vacío)
+static void reiniciarLimpio() {
+  guardarPendientes();
+  Preferences::datos().clear();
+  Telemetria_begin();
+}
+
+static void cerrarUnMinuto() {
+  sim_avanzar(TELEM_MS_MINUTO);
+  Telemetria_loop();
+  guardarPendientes();
+}
+
+// Filas del CSV sin la cabecera ni la marca de tiempo (depende del reloj real)
+static std::vector<std::string> filasCSV(ResolucionTelemetria res, uint16_t maxMuestras = 0) {
+  Captura c;
+  size_t n = Telemetria_exportarCSV(c, res, maxMuestras);
+  std::vector<std::string> filas;
+  if (n != c.datos.size()) return filas;
+
+  size_t p = c.datos.find('\n') + 1;
+  while (p < c.datos.size()) {
+    size_t fin = c.datos.find('\n', p);
+    std::string fila = c.datos.substr(p, fin - p);
+    filas.push_back(fila.substr(fila.find(',') + 1));
+    p = fin + 1;
+  }
+  return filas;
+}
+
+static std::string fila(unsigned ciclos, unsigned alarmas, unsigned vMin, unsigned vProm,
+                        unsigned vMax, unsigned lMin, unsigned lProm, unsigned lMax) {
+  char s[96];
+  snprintf(s, sizeof(s), "%u,%u,%u,%u,%u,%u,%u,%u", ciclos, alarmas, vMin, vProm, vMax,
+           lMin, lProm, lMax);
+  return s;
+}
+
+// Minuto 'i' del escenario por minutos
+static std::string filaMinuto(unsigned i) {
+  bool viaje = (i % 2 == 0);
+  return fila(i % 3, i % 10 == 0, viaje ? 100 + i : 0, viaje ? 100 + i : 0, viaje ? 100 + i : 0,
+              100 + i, 200 + i, 300 + i);
+}
+
+static void registrarMinuto(unsigned i) {
+  for (unsigned c = 0; c < i % 3; c++) Telemetria_registrarCiclo();
+  if (i % 10 == 0) Telemetria_registrarAlarma();
+  if (i % 2 == 0)  Telemetria_registrarViaje((100 + i) * 100);
+  Telemetria_registrarLoop(100 + i);
+  Telemetria_registrarLoop(300 + i);
+}
+
+static void pruebaMinutosYHora() {
+
+  reiniciarLimpio();
+
+  // ---- Una hora: 60 minutos distintos ----
+  for (unsigned i = 0; i < 60; i++) {
+    registrarMinuto(i);
+    cerrarUnMinuto();
+  }
+
+  std::vector<std::string> minutos = filasCSV(TELEM_MINUTO);
+  VERIFICAR(minutos.size() == 60, "cantidad de minutos");
+  bool iguales = minutos.size() == 60;
+  for (unsigned i = 0; iguales && i < 60; i++) iguales = (minutos[i] == filaMinuto(i));
+  VERIFICAR(iguales, "consolidacion por minuto");
+
+  // Hora: sumas exactas y mín / prom / máx sobre todas las muestras
+  //   ciclos 20×(0+1+2), alarmas 6, viajes 100..158 pares (prom 129),
+  //   loops 100..159 y 300..359 (prom 27540 / 120 = 229)
+  std::vector<std::string> horas = filasCSV(TELEM_HORA);
+  VERIFICAR(horas.size() == 1 && horas[0] == fila(60, 6, 100, 129, 158, 100, 229, 359),
+            "consolidacion de la hora");
+
+  // maxMuestras: las más nuevas, de la más vieja a la más nueva
+  std::vector<std::string> ultimos = filasCSV(TELEM_MINUTO, 5);
+  VERIFICAR(ultimos.size() == 5 && ultimos[0] == filaMinuto(55) && ultimos[4] == filaMinuto(59),
+            "CSV con maxMuestras");
+  VERIFICAR(filasCSV(TELEM_HORA, 10).size() == 1, "maxMuestras mayor que la cantidad");
+
+  // ---- Vuelta del archivo de minutos ----
+  for (unsigned i = 60; i < 70; i++) {
+    registrarMinuto(i);
+    cerrarUnMinuto();
+  }
+  minutos = filasCSV(TELEM_MINUTO);
+  VERIFICAR(minutos.size() == 60 && minutos[0] == filaMinuto(10) && minutos[59] == filaMinuto(69),
+            "vuelta del archivo de minutos");
+
+  // ---- Binario: cabecera y muestras en orden a través del fin del buffer ----
+  const uint16_t pedidos[] = { 0, 15, 50 };
+  for (uint16_t pedido : pedidos) {
+    uint16_t cantidad = pedido ? pedido : 60;
+    Captura c;
+    size_t n = Telemetria_exportarBinario(c, TELEM_MINUTO, pedido);
+    const uint8_t* d = (const uint8_t*)c.datos.data();
+
+    VERIFICAR(n == c.datos.size() && n == 8 + cantidad * sizeof(MuestraTelemetria),
+              "largo del binario");
+    if (n != 8 + cantidad * sizeof(MuestraTelemetria)) continue;
+    VERIFICAR(memcmp(d, "PTEL", 4) == 0 && d[4] == TELEM_VERSION && d[5] == TELEM_MINUTO &&
+              (d[6] | (d[7] << 8)) == cantidad, "cabecera del binario");
+
+    bool enOrden = true;
+    for (uint16_t k = 0; k < cantidad; k++) {
+      MuestraTelemetria m;
+      memcpy(&m, d + 8 + k * sizeof(m), sizeof(m));
+      unsigned i = 70 - cantidad + k;
+      enOrden &= (m.loopMin == 100 + i && m.loopMax == 300 + i && m.ciclos == i % 3);
+    }
+    VERIFICAR(enOrden, "muestras del binario fuera de orden");
+  }
+}
+
+static void pruebaHorasYDias() {
+
+  reiniciarLimpio();
+
+  // 33 días: el día 'd' registra d + 1 ciclos en su primer minuto
+  const unsigned dias = TELEM_CAP_DIAS + 2;
+  for (unsigned d = 0; d < dias; d++) {
+    for (unsigned m = 0; m < TELEM_MIN_POR_HORA * TELEM_HORAS_POR_DIA; m++) {
+      if (m == 0) {
+        for (unsigned c = 0; c <= d; c++) Telemetria_registrarCiclo();
+      }
+      Telemetria_registrarLoop(50);
+      cerrarUnMinuto();
+    }
+  }
+
+  // ---- Días: vuelta del archivo (quedan los días 2..32) ----
+  std::vector<std::string> filasDias = filasCSV(TELEM_DIA);
+  VERIFICAR(filasDias.size() == TELEM_CAP_DIAS, "cantidad de dias");
+  bool diasOk = filasDias.size() == TELEM_CAP_DIAS;
+  for (unsigned k = 0; diasOk && k < TELEM_CAP_DIAS; k++) {
+    diasOk = (filasDias[k] == fila(k + 3, 0, 0, 0, 0, 50, 50, 50));
+  }
+  VERIFICAR(diasOk, "consolidacion / vuelta del archivo de dias");
+
+  // ---- Horas: las últimas 48 (días 31 y 32) ----
+  std::vector<std::string> filasHoras = filasCSV(TELEM_HORA);
+  VERIFICAR(filasHoras.size() == TELEM_CAP_HORAS, "cantidad de horas");
+  bool horasOk = filasHoras.size() == TELEM_CAP_HORAS;
+  for (unsigned k = 0; horasOk && k < TELEM_CAP_HORAS; k++) {
+    unsigned d = dias - 2 + k / TELEM_HORAS_POR_DIA;
+    unsigned ciclos = (k % TELEM_HORAS_POR_DIA == 0) ? d + 1 : 0;
+    horasOk = (filasHoras[k] == fila(ciclos, 0, 0, 0, 0, 50, 50, 50));
+  }
+  VERIFICAR(horasOk, "consolidacion / vuelta del archivo de horas");
+
+  // ---- Binario de días: dos tramos (cabeza en 2) ----
+  Captura c;
+  Telemetria_exportarBinario(c, TELEM_DIA);
+  bool binOk = c.datos.size() == 8 + TELEM_CAP_DIAS * sizeof(MuestraTelemetria);
+  for (unsigned k = 0; binOk && k < TELEM_CAP_DIAS; k++) {
+    MuestraTelemetria m;
+    memcpy(&m, c.datos.data() + 8 + k * sizeof(m), sizeof(m));
+    binOk = (m.ciclos == k + 3 && m.loopProm == 50);
+  }
+  VERIFICAR(binOk, "binario de dias");
+
+  // ---- Tras un reinicio el RRD vuelve del último cierre de hora ----
+  guardarPendientes();
+  Telemetria_begin();
+  VERIFICAR(filasCSV(TELEM_DIA) == filasDias, "dias no restaurados");
+}
+
+// =================================================================================
+// MAIN
+// =================================================================================
+int main() {
+
+  sim_reiniciarTiempo(1000);
+  Telemetria_begin();
+  VERIFICAR(Telemetria_totalCiclos() == 0, "arranque sin datos con totales");
+  VERIFICAR(tareaGuardado != nullptr, "tarea de guardado no creada");
+
+  // ---- El loop() no escribe: copia y avisa a la tarea ----
+  uint32_t antes = Preferences::escrituras();
+  Telemetria_registrarCiclo();
+  sim_avanzar(10);
+  Telemetria_loop();
+  VERIFICAR(Preferences::escrituras() == antes && totalesPendientes, "totales escritos en el loop");
+  guardarPendientes();
+  VERIFICAR(Preferences::escrituras() == antes + 1, "la tarea no guardo los totales");
+
+  for (int i = 0; i < 60; i++) {
+    sim_avanzar(TELEM_MS_MINUTO);
+    Telemetria_loop();
+  }
+  VERIFICAR(Preferences::escrituras() == antes + 1 && rrdPendiente, "RRD escrito en el loop");
+  guardarPendientes();
+  VERIFICAR(Preferences::escrituras() == antes + 2, "la tarea no guardo el RRD");
+
+  // ---- Primer cambio: checkpoint inmediato ----
+  uint32_t escrituras = Preferences::escrituras();
+  Telemetria_registrarCiclo();
+  correr(10);
+  VERIFICAR(Preferences::escrituras() == escrituras + 1, "primer ciclo no guardado");
+
+  // ---- Ráfaga: un checkpoint por ventana de 30 s ----
+  escrituras = Preferences::escrituras();
+  for (int i = 0; i < 100; i++) {
+    Telemetria_registrarCiclo();
+    correr(600);
+  }
+  uint32_t enRafaga = Preferences::escrituras() - escrituras;
+  VERIFICAR(enRafaga >= 2 && enRafaga <= 3, "checkpoints de totales sin limite de frecuencia");
+
+  correr(30000);
+  VERIFICAR(Telemetria_totalCiclos() == 102, "totales en RAM");
+
+  // ---- Reinicio: se recupera el checkpoint ----
+  Telemetria_begin();
+  VERIFICAR(Telemetria_totalCiclos() == 102, "totales perdidos al reiniciar");
+
+  // ---- Corte antes del checkpoint: se pierde solo lo de la ventana ----
+  Telemetria_registrarAlarma();
+  correr(10);                                 // Guardada (ventana vencida)
+  Telemetria_registrarAlarma();
+  correr(1000);                               // Pendiente: corte antes de 30 s
+  Telemetria_begin();
+  VERIFICAR(Telemetria_totalAlarmas() == 1, "alarma del checkpoint perdida");
+
+  // ---- El RRD horario no pisa totales más nuevos ----
+  Telemetria_guardar();
+  Telemetria_registrarCiclo();
+  correr(10);
+  Telemetria_begin();
+  VERIFICAR(Telemetria_totalCiclos() == 103, "RRD viejo piso los totales");
+
+  pruebaMinutosYHora();
+  pruebaHorasYDias();
+
+  printf("telemetria: %d fallas\n", fallas);
+  return fallas ? 1 : 0;
+}
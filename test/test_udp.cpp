@@ -0,0 +1,243 @@
+// =================================================================================
+// TEST DE LOOPBACK – PROTOCOLO UDP
+// =================================================================================
+// Compila el ProtocoloUDP.cpp real (sockets POSIX, HMAC de tools/Sha256) y le
+// habla con el cliente de tools/ por 127.0.0.1:
+//
+//   1. Funcional: consulta, MAC inválida, sesión, duplicados, secuencia vieja,
+//      comando desconocido y avisos con su límite de frecuencia.
+//   2. Carga: el loop() del equipo corre en un hilo mientras el cliente hace
+//      consultas en serie y ráfagas. Se mide consultas/s y el costo por vuelta
+//      de ProtocoloUDP_loop() (jitter que agrega al loop principal).
+//
+// Falla si no se cumplen los umbrales de la sección 1.
+// =================================================================================
+
+#define UDP_CLAVE            "clave-de-prueba"
+#define UDP_PUERTO           47210
+#define UDP_MULTICAST_IP     "127.0.0.1"
+#define UDP_MULTICAST_PUERTO 47211
+
+#define SIN_MAIN_CPP
+
+#include "../ProtocoloUDP.cpp"
+#include "../tools/ClienteUDP.h"
+#include "simulador.h"
+#include "verificacion.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// =================================================================================
+// 1. UMBRALES
+// =================================================================================
+#define MIN_CONSULTAS_POR_SEG  2000
+#define MAX_LOOP_P99_US        100     // ProtocoloUDP_loop() con tráfico
+#define CONSULTAS_CARGA        5000
+#define PULSOS_CARGA           200
+#define TRAMAS_RAFAGA          64
+
+// =================================================================================
+// 2. HELPERS
+// =================================================================================
+// Hace correr el loop() del equipo hasta que el cliente recibe algo
+static size_t esperarRespuesta(ClienteUDP& c, void* buf, size_t largo, int vueltas = 50) {
+  for (int i = 0; i < vueltas; i++) {
+    ProtocoloUDP_loop();
+    sim_avanzar(1);
+    size_t n = ClienteUDP_recibir(c, buf, largo, 1);
+    if (n) return n;
+  }
+  return 0;
+}
+
+static uint8_t comandoYAck(ClienteUDP& c, uint8_t comando, uint32_t ses, uint32_t secuencia) {
+  ClienteUDP_enviarComando(c, comando, ses, secuencia);
+  uint8_t buf[64];
+  size_t n = esperarRespuesta(c, buf, sizeof(buf));
+  if (n != sizeof(TramaAckUDP)) return 0xFF;
+  const TramaAckUDP* ack = (const TramaAckUDP*)buf;
+  return ack->cab.secuencia == secuencia ? ack->resultado : 0xFE;
+}
+
+// =================================================================================
+// 3. FUNCIONAL
+// =================================================================================
+static void pruebasFuncionales(ClienteUDP& c, ClienteUDP& grupo) {
+
+  uint8_t buf[64];
+
+  // ---- Consulta ----
+  ClienteUDP_enviarConsulta(c, 10);
+  size_t n = esperarRespuesta(c, buf, sizeof(buf));
+  VERIFICAR(n == sizeof(TramaEstadoUDP), "consulta sin ESTADO");
+  const TramaEstadoUDP* e = (const TramaEstadoUDP*)buf;
+  VERIFICAR(e->cab.secuencia == 10, "ESTADO no repite la secuencia");
+  VERIFICAR(e->cab.sesion == sesion, "ESTADO con otra sesion");
+  VERIFICAR(e->estadoPorton == 1, "ESTADO con porton incorrecto");
+  VERIFICAR(c.sesion == sesion, "el cliente no tomo la sesion");
+
+  // ---- MAC inválida: sin respuesta ----
+  TramaConsultaUDP mala;
+  memset(&mala, 0, sizeof(mala));
+  mala.cab.magia[0] = 'P';
+  mala.cab.magia[1] = 'U';
+  mala.cab.version  = UDP_VERSION_PROTOCOLO;
+  mala.cab.tipo     = UDP_CONSULTA;
+  sendto(c.sock, &mala, sizeof(mala), 0, (sockaddr*)&c.destino, sizeof(c.destino));
+  VERIFICAR(esperarRespuesta(c, buf, sizeof(buf), 20) == 0, "respondio a MAC invalida");
+
+  // ---- Comandos ----
+  solicitudPulso = false;
+  VERIFICAR(comandoYAck(c, UDP_CMD_PULSO, sesion + 1, 5) == UDP_ACK_SESION, "sesion ajena aceptada");
+  VERIFICAR(!solicitudPulso, "pulso con sesion ajena");
+
+  VERIFICAR(comandoYAck(c, UDP_CMD_PULSO, sesion, 5) == UDP_ACK_ACEPTADO, "comando valido rechazado");
+  VERIFICAR(solicitudPulso, "comando aceptado sin pulso");
+  VERIFICAR(eventosRegistrados == 1, "comando aceptado sin evento");
+
+  solicitudPulso = false;
+  VERIFICAR(comandoYAck(c, UDP_CMD_PULSO, sesion, 5) == UDP_ACK_DUPLICADO, "duplicado no detectado");
+  VERIFICAR(!solicitudPulso, "duplicado repitio el pulso");
+
+  VERIFICAR(comandoYAck(c, UDP_CMD_PULSO, sesion, 4) == UDP_ACK_VIEJO, "secuencia vieja aceptada");
+  VERIFICAR(comandoYAck(c, 99, sesion, 6) == UDP_ACK_DESCONOCIDO, "comando desconocido aceptado");
+  VERIFICAR(!solicitudPulso && eventosRegistrados == 1, "pulso por comando rechazado");
+
+  // ---- Tramas por vuelta acotadas (costo máximo de ProtocoloUDP_loop) ----
+  for (int i = 0; i < 10; i++) ClienteUDP_enviarConsulta(c, 100 + i);
+  usleep(2000);
+  ProtocoloUDP_loop();
+  int respondidas = 0;
+  while (ClienteUDP_recibir(c, buf, sizeof(buf), 5)) respondidas++;
+  VERIFICAR(respondidas == UDP_MAX_TRAMAS_POR_LOOP, "mas tramas por vuelta que el limite");
+  while (esperarRespuesta(c, buf, sizeof(buf), 5)) {}
+
+  // ---- Avisos: uno por cambio, con límite de frecuencia ----
+  sim_avanzar(UDP_MIN_ENTRE_AVISOS_MS);
+  while (esperarRespuesta(grupo, buf, sizeof(buf), 5)) {}   // Aviso inicial
+
+  estadoPortonUI = 3;
+  n = esperarRespuesta(grupo, buf, sizeof(buf), 5);
+  VERIFICAR(n == sizeof(TramaEstadoUDP) && ((TramaEstadoUDP*)buf)->estadoPorton == 3,
+            "sin aviso del cambio");
+
+  estadoPortonUI = 6;
+  VERIFICAR(esperarRespuesta(grupo, buf, sizeof(buf), UDP_MIN_ENTRE_AVISOS_MS / 2) == 0,
+            "aviso antes del intervalo minimo");
+  n = esperarRespuesta(grupo, buf, sizeof(buf), UDP_MIN_ENTRE_AVISOS_MS);
+  VERIFICAR(n == sizeof(TramaEstadoUDP) && ((TramaEstadoUDP*)buf)->estadoPorton == 6,
+            "aviso postergado perdido");
+}
+
+// =================================================================================
+// 4. CARGA
+// =================================================================================
+static std::atomic<bool> correr(true);
+static uint32_t histogramaUs[1001];     // Último casillero: ≥ 1000 µs
+static uint64_t vueltasEquipo = 0;
+static double   peorVueltaUs  = 0;
+
+static void hiloEquipo() {
+  using namespace std::chrono;
+  while (correr) {
+    auto t0 = steady_clock::now();
+    ProtocoloUDP_loop();
+    double us = duration_cast<nanoseconds>(steady_clock::now() - t0).count() / 1000.0;
+
+    histogramaUs[us < 1000 ? (int)us : 1000]++;
+    if (us > peorVueltaUs) peorVueltaUs = us;
+    vueltasEquipo++;
+
+    sim_avanzar(1);
+    std::this_thread::yield();
+  }
+}
+
+static uint32_t percentilUs(double p) {
+  uint64_t objetivo = (uint64_t)(vueltasEquipo * p);
+  uint64_t acumulado = 0;
+  for (uint32_t i = 0; i <= 1000; i++) {
+    acumulado += histogramaUs[i];
+    if (acumulado > objetivo) return i;
+  }
+  return 1000;
+}
+
+static void pruebaCarga(ClienteUDP& c) {
+
+  using namespace std::chrono;
+  std::thread equipo(hiloEquipo);
+
+  // ---- Consultas en serie ----
+  int respondidas = 0;
+  auto t0 = steady_clock::now();
+  for (int i = 0; i < CONSULTAS_CARGA; i++) {
+    TramaEstadoUDP e;
+    if (ClienteUDP_consultar(c, e, 200)) respondidas++;
+  }
+  double seg = duration_cast<microseconds>(steady_clock::now() - t0).count() / 1e6;
+  double porSeg = respondidas / seg;
+
+  // ---- Pulsos (secuencia creciente, todos aceptados) ----
+  int aceptados = 0;
+  for (int i = 0; i < PULSOS_CARGA; i++) {
+    ResultadoUDP r;
+    if (ClienteUDP_pulso(c, r, 200) && r == UDP_ACK_ACEPTADO) aceptados++;
+  }
+
+  // ---- Ráfaga: muchas tramas sin esperar ----
+  for (int i = 0; i < TRAMAS_RAFAGA; i++) ClienteUDP_enviarConsulta(c, ++c.secuencia);
+  int rafaga = 0;
+  uint8_t buf[64];
+  while (ClienteUDP_recibir(c, buf, sizeof(buf), 200)) rafaga++;
+
+  correr = false;
+  equipo.join();
+
+  uint32_t p50 = percentilUs(0.50);
+  uint32_t p99 = percentilUs(0.99);
+
+  printf("carga: %d/%d consultas, %.0f consultas/s | pulsos aceptados %d/%d | rafaga %d/%d\n",
+         respondidas, CONSULTAS_CARGA, porSeg, aceptados, PULSOS_CARGA, rafaga, TRAMAS_RAFAGA);
+  printf("ProtocoloUDP_loop(): %lu vueltas, p50=%u us p99=%u us max=%.0f us "
+         "(jitter p99-p50=%u us)\n",
+         (unsigned long)vueltasEquipo, p50, p99, peorVueltaUs, p99 - p50);
+
+  VERIFICAR(respondidas == CONSULTAS_CARGA, "consultas sin respuesta en loopback");
+  VERIFICAR(porSeg >= MIN_CONSULTAS_POR_SEG, "consultas/s bajo el umbral");
+  VERIFICAR(aceptados == PULSOS_CARGA, "pulsos no aceptados");
+  VERIFICAR(rafaga == TRAMAS_RAFAGA, "rafaga con perdidas");
+  VERIFICAR(p99 <= MAX_LOOP_P99_US, "p99 de ProtocoloUDP_loop() sobre el umbral");
+}
+
+// =================================================================================
+// 5. MAIN
+// =================================================================================
+int main() {
+
+  sim_reiniciarTiempo(1000);
+  sim_wifiConectado(true);
+
+  ProtocoloUDP_begin();
+  ProtocoloUDP_loop();
+  if (sock < 0) {
+    printf("no se pudo abrir el puerto %d\n", UDP_PUERTO);
+    return 1;
+  }
+
+  ClienteUDP c, grupo;
+  ClienteUDP_abrir(c, "127.0.0.1", UDP_PUERTO, UDP_CLAVE);
+  ClienteUDP_abrir(grupo, "127.0.0.1", UDP_PUERTO, UDP_CLAVE);
+  if (!ClienteUDP_unirseGrupo(grupo, UDP_MULTICAST_IP, UDP_MULTICAST_PUERTO)) {
+    printf("no se pudo abrir el puerto %d\n", UDP_MULTICAST_PUERTO);
+    return 1;
+  }
+
+  pruebasFuncionales(c, grupo);
+  pruebaCarga(c);
+
+  if (fallas) printf("%d fallas\n", fallas);
+  return fallas ? 1 : 0;
+}
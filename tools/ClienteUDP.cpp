@@ -0,0 +1,202 @@
+#include "ClienteUDP.h"
+
+#include <arpa/inet.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+// =================================================================================
+// 1. HELPERS
+// =================================================================================
+static void calcularMac(ClienteUDP& c, const void* datos, size_t largo, uint8_t* mac) {
+  uint8_t completo[SHA256_LARGO];
+  HmacSha256_reiniciar(c.hmac);
+  HmacSha256_agregar(c.hmac, datos, largo);
+  HmacSha256_terminar(c.hmac, completo);
+  memcpy(mac, completo, UDP_LARGO_MAC);
+}
+
+static bool macValida(ClienteUDP& c, const void* trama, size_t largo) {
+  uint8_t esperada[UDP_LARGO_MAC];
+  calcularMac(c, trama, largo - UDP_LARGO_MAC, esperada);
+  return memcmp(esperada, (const uint8_t*)trama + largo - UDP_LARGO_MAC, UDP_LARGO_MAC) == 0;
+}
+
+static void armarCabecera(CabeceraUDP& cab, TipoTramaUDP tipo, uint32_t sesion, uint32_t secuencia) {
+  cab.magia[0]  = 'P';
+  cab.magia[1]  = 'U';
+  cab.version   = UDP_VERSION_PROTOCOLO;
+  cab.tipo      = tipo;
+  cab.sesion    = sesion;
+  cab.secuencia = secuencia;
+}
+
+static size_t largoEsperado(uint8_t tipo) {
+  switch (tipo) {
+    case UDP_ESTADO: return sizeof(TramaEstadoUDP);
+    case UDP_ACK:    return sizeof(TramaAckUDP);
+    default:         return 0;
+  }
+}
+
+static long msAhora() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+// =================================================================================
+// 2. SOCKET
+// =================================================================================
+bool ClienteUDP_abrir(ClienteUDP& c, const char* ip, uint16_t puerto, const char* clave) {
+
+  memset(&c, 0, sizeof(c));
+  c.sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (c.sock < 0) return false;
+
+  c.destino.sin_family = AF_INET;
+  c.destino.sin_port   = htons(puerto);
+  if (inet_pton(AF_INET, ip, &c.destino.sin_addr) != 1) {
+    ClienteUDP_cerrar(c);
+    return false;
+  }
+
+  HmacSha256_iniciar(c.hmac, clave, strlen(clave));
+
+  // Secuencia inicial creciente entre ejecuciones (el equipo rechaza las viejas)
+  c.secuencia = (uint32_t)time(nullptr);
+  return true;
+}
+
+void ClienteUDP_cerrar(ClienteUDP& c) {
+  if (c.sock >= 0) close(c.sock);
+  c.sock = -1;
+}
+
+bool ClienteUDP_unirseGrupo(ClienteUDP& c, const char* grupo, uint16_t puerto) {
+
+  int si = 1;
+  setsockopt(c.sock, SOL_SOCKET, SO_REUSEADDR, &si, sizeof(si));
+
+  sockaddr_in local;
+  memset(&local, 0, sizeof(local));
+  local.sin_family      = AF_INET;
+  local.sin_port        = htons(puerto);
+  local.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(c.sock, (sockaddr*)&local, sizeof(local)) < 0) return false;
+
+  // Con una dirección unicast (tests en loopback) alcanza con el bind
+  in_addr_t direccion = inet_addr(grupo);
+  if (!IN_MULTICAST(ntohl(direccion))) return true;
+
+  ip_mreq m;
+  m.imr_multiaddr.s_addr = direccion;
+  m.imr_interface.s_addr = htonl(INADDR_ANY);
+  return setsockopt(c.sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &m, sizeof(m)) == 0;
+}
+
+// =================================================================================
+// 3. BAJO NIVEL
+// =================================================================================
+bool ClienteUDP_enviarConsulta(ClienteUDP& c, uint32_t secuencia) {
+  TramaConsultaUDP t;
+  armarCabecera(t.cab, UDP_CONSULTA, c.sesion, secuencia);
+  calcularMac(c, &t, sizeof(t) - UDP_LARGO_MAC, t.mac);
+  return sendto(c.sock, &t, sizeof(t), 0, (sockaddr*)&c.destino, sizeof(c.destino)) == sizeof(t);
+}
+
+bool ClienteUDP_enviarComando(ClienteUDP& c, uint8_t comando, uint32_t sesion, uint32_t secuencia) {
+  TramaComandoUDP t;
+  armarCabecera(t.cab, UDP_COMANDO, sesion, secuencia);
+  t.comando = comando;
+  memset(t.reservado, 0, sizeof(t.reservado));
+  calcularMac(c, &t, sizeof(t) - UDP_LARGO_MAC, t.mac);
+  return sendto(c.sock, &t, sizeof(t), 0, (sockaddr*)&c.destino, sizeof(c.destino)) == sizeof(t);
+}
+
+size_t ClienteUDP_recibir(ClienteUDP& c, void* buf, size_t largo, int esperaMs) {
+
+  long limite = msAhora() + esperaMs;
+
+  for (;;) {
+    long resta = limite - msAhora();
+    if (resta < 0) return 0;
+
+    pollfd p = { c.sock, POLLIN, 0 };
+    if (poll(&p, 1, (int)resta) <= 0) return 0;
+
+    ssize_t n = recv(c.sock, buf, largo, 0);
+    if (n < (ssize_t)sizeof(CabeceraUDP)) continue;
+
+    const CabeceraUDP* cab = (const CabeceraUDP*)buf;
+    if (cab->magia[0] != 'P' || cab->magia[1] != 'U' ||
+        cab->version != UDP_VERSION_PROTOCOLO) continue;
+    if ((size_t)n != largoEsperado(cab->tipo)) continue;
+    if (!macValida(c, buf, (size_t)n)) continue;
+
+    if (cab->tipo == UDP_ESTADO) c.sesion = cab->sesion;
+    return (size_t)n;
+  }
+}
+
+// =================================================================================
+// 4. ALTO NIVEL
+// =================================================================================
+bool ClienteUDP_consultar(ClienteUDP& c, TramaEstadoUDP& estado, int esperaMs) {
+
+  uint32_t secuencia = ++c.secuencia;
+  if (!ClienteUDP_enviarConsulta(c, secuencia)) return false;
+
+  // Se descartan respuestas atrasadas de consultas anteriores
+  uint8_t buf[64];
+  long limite = msAhora() + esperaMs;
+  for (long resta = esperaMs; resta >= 0; resta = limite - msAhora()) {
+    size_t n = ClienteUDP_recibir(c, buf, sizeof(buf), (int)resta);
+    if (n == 0) return false;
+    const CabeceraUDP* cab = (const CabeceraUDP*)buf;
+    if (cab->tipo == UDP_ESTADO && cab->secuencia == secuencia) {
+      memcpy(&estado, buf, sizeof(estado));
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ClienteUDP_pulso(ClienteUDP& c, ResultadoUDP& resultado, int esperaMs, int intentos) {
+
+  if (c.sesion == 0) {
+    TramaEstadoUDP e;
+    if (!ClienteUDP_consultar(c, e, esperaMs)) return false;
+  }
+
+  uint32_t secuencia = ++c.secuencia;
+
+  for (int i = 0; i < intentos; i++) {
+
+    if (!ClienteUDP_enviarComando(c, UDP_CMD_PULSO, c.sesion, secuencia)) return false;
+
+    uint8_t buf[64];
+    long limite = msAhora() + esperaMs;
+    for (long resta = esperaMs; resta >= 0; resta = limite - msAhora()) {
+
+      size_t n = ClienteUDP_recibir(c, buf, sizeof(buf), (int)resta);
+      if (n == 0) break;
+
+      const TramaAckUDP* ack = (const TramaAckUDP*)buf;
+      if (ack->cab.tipo != UDP_ACK || ack->cab.secuencia != secuencia) continue;
+
+      // Equipo reiniciado: se adopta la sesión nueva y se reintenta una vez
+      if (ack->resultado == UDP_ACK_SESION && c.sesion != ack->cab.sesion) {
+        c.sesion  = ack->cab.sesion;
+        secuencia = ++c.secuencia;
+        break;
+      }
+
+      resultado = (ResultadoUDP)ack->resultado;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+// =================================================================================
+// CLIENTE UDP (Linux) – PROTOCOLO DE ESTADO Y COMANDOS DEL PORTÓN
+// =================================================================================
+// Usa las tramas de ProtocoloUDP.h tal cual las define el firmware.
+//
+//   ClienteUDP c;
+//   ClienteUDP_abrir(c, "192.168.1.50", 4210, "clave");
+//   TramaEstadoUDP e;  ClienteUDP_consultar(c, e, 500);
+//   ResultadoUDP r;    ClienteUDP_pulso(c, r, 500);
+//
+// La sesión del equipo se toma de la última trama ESTADO recibida. Los comandos
+// se reintentan con la MISMA secuencia: el equipo responde ACK_DUPLICADO sin
+// repetir el pulso si el primero había llegado.
+// =================================================================================
+
+#include <stdint.h>
+#include <stddef.h>
+#include <netinet/in.h>
+
+#include "ProtocoloUDP.h"
+#include "Sha256.h"
+
+struct ClienteUDP {
+  int         sock;
+  sockaddr_in destino;
+  HmacSha256  hmac;
+  uint32_t    sesion;          // 0 = desconocida
+  uint32_t    secuencia;       // Última usada
+};
+
+bool ClienteUDP_abrir(ClienteUDP& c, const char* ip, uint16_t puerto, const char* clave);
+void ClienteUDP_cerrar(ClienteUDP& c);
+
+// Escucha los avisos multicast del equipo en vez de hablarle
+bool ClienteUDP_unirseGrupo(ClienteUDP& c, const char* grupo, uint16_t puerto);
+
+// ---- Bajo nivel (tests) ----
+bool ClienteUDP_enviarConsulta(ClienteUDP& c, uint32_t secuencia);
+bool ClienteUDP_enviarComando(ClienteUDP& c, uint8_t comando, uint32_t sesion, uint32_t secuencia);
+
+// Próxima trama con cabecera y MAC válidas (las demás se descartan).
+// Devuelve el largo o 0 si vence 'esperaMs'.
+size_t ClienteUDP_recibir(ClienteUDP& c, void* buf, size_t largo, int esperaMs);
+
+// ---- Alto nivel ----
+bool ClienteUDP_consultar(ClienteUDP& c, TramaEstadoUDP& estado, int esperaMs);
+bool ClienteUDP_pulso(ClienteUDP& c, ResultadoUDP& resultado, int esperaMs, int intentos = 3);
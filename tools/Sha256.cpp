@@ -0,0 +1,146 @@
+#include "Sha256.h"
+
+#include <string.h>
+
+// =================================================================================
+// 1. CONSTANTES
+// =================================================================================
+static const uint32_t K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32_t rotr(uint32_t x, uint8_t n) { return (x >> n) | (x << (32 - n)); }
+
+// =================================================================================
+// 2. SHA-256
+// =================================================================================
+static void procesarBloque(Sha256& s, const uint8_t* p) {
+
+  uint32_t w[64];
+  for (int i = 0; i < 16; i++) {
+    w[i] = ((uint32_t)p[4 * i] << 24) | ((uint32_t)p[4 * i + 1] << 16) |
+           ((uint32_t)p[4 * i + 2] << 8) | p[4 * i + 3];
+  }
+  for (int i = 16; i < 64; i++) {
+    uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19)  ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+
+  uint32_t a = s.h[0], b = s.h[1], c = s.h[2], d = s.h[3];
+  uint32_t e = s.h[4], f = s.h[5], g = s.h[6], h = s.h[7];
+
+  for (int i = 0; i < 64; i++) {
+    uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+    uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+    h = g; g = f; f = e; e = d + t1;
+    d = c; c = b; b = a; a = t1 + t2;
+  }
+
+  s.h[0] += a; s.h[1] += b; s.h[2] += c; s.h[3] += d;
+  s.h[4] += e; s.h[5] += f; s.h[6] += g; s.h[7] += h;
+}
+
+void Sha256_iniciar(Sha256& s) {
+  static const uint32_t h0[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+  };
+  memcpy(s.h, h0, sizeof(h0));
+  s.total  = 0;
+  s.usados = 0;
+}
+
+void Sha256_agregar(Sha256& s, const void* datos, size_t largo) {
+
+  const uint8_t* p = (const uint8_t*)datos;
+  s.total += largo;
+
+  while (largo > 0) {
+    size_t n = 64 - s.usados;
+    if (n > largo) n = largo;
+    memcpy(s.bloque + s.usados, p, n);
+    s.usados += n;
+    p += n;
+    largo -= n;
+
+    if (s.usados == 64) {
+      procesarBloque(s, s.bloque);
+      s.usados = 0;
+    }
+  }
+}
+
+void Sha256_terminar(Sha256& s, uint8_t resumen[SHA256_LARGO]) {
+
+  uint64_t bits = s.total * 8;
+
+  uint8_t relleno = 0x80;
+  Sha256_agregar(s, &relleno, 1);
+  relleno = 0;
+  while (s.usados != 56) Sha256_agregar(s, &relleno, 1);
+
+  uint8_t largo[8];
+  for (int i = 0; i < 8; i++) largo[i] = (uint8_t)(bits >> (56 - 8 * i));
+  Sha256_agregar(s, largo, 8);
+
+  for (int i = 0; i < 8; i++) {
+    resumen[4 * i]     = (uint8_t)(s.h[i] >> 24);
+    resumen[4 * i + 1] = (uint8_t)(s.h[i] >> 16);
+    resumen[4 * i + 2] = (uint8_t)(s.h[i] >> 8);
+    resumen[4 * i + 3] = (uint8_t)(s.h[i]);
+  }
+}
+
+// =================================================================================
+// 3. HMAC
+// =================================================================================
+void HmacSha256_iniciar(HmacSha256& h, const void* clave, size_t largoClave) {
+
+  uint8_t k[64];
+  memset(k, 0, sizeof(k));
+
+  // Claves largas se reemplazan por su resumen (RFC 2104)
+  if (largoClave > 64) {
+    Sha256 s;
+    Sha256_iniciar(s);
+    Sha256_agregar(s, clave, largoClave);
+    Sha256_terminar(s, k);
+  } else {
+    memcpy(k, clave, largoClave);
+  }
+
+  for (int i = 0; i < 64; i++) {
+    h.claveInterna[i] = k[i] ^ 0x36;
+    h.claveExterna[i] = k[i] ^ 0x5c;
+  }
+
+  HmacSha256_reiniciar(h);
+}
+
+void HmacSha256_reiniciar(HmacSha256& h) {
+  Sha256_iniciar(h.interno);
+  Sha256_agregar(h.interno, h.claveInterna, 64);
+}
+
+void HmacSha256_agregar(HmacSha256& h, const void* datos, size_t largo) {
+  Sha256_agregar(h.interno, datos, largo);
+}
+
+void HmacSha256_terminar(HmacSha256& h, uint8_t mac[SHA256_LARGO]) {
+
+  uint8_t interno[SHA256_LARGO];
+  Sha256_terminar(h.interno, interno);
+
+  Sha256 externo;
+  Sha256_iniciar(externo);
+  Sha256_agregar(externo, h.claveExterna, 64);
+  Sha256_agregar(externo, interno, sizeof(interno));
+  Sha256_terminar(externo, mac);
+}
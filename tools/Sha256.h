@@ -0,0 +1,35 @@
+#pragma once
+
+// =================================================================================
+// SHA-256 / HMAC-SHA256 (sin dependencias) – herramientas de PC y tests host
+// =================================================================================
+// El firmware usa mbedtls; esto replica el mismo cálculo en Linux sin librerías.
+// =================================================================================
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SHA256_LARGO 32
+
+struct Sha256 {
+  uint32_t h[8];
+  uint8_t  bloque[64];
+  uint64_t total;          // bytes procesados
+  size_t   usados;         // bytes en 'bloque'
+};
+
+void Sha256_iniciar(Sha256& s);
+void Sha256_agregar(Sha256& s, const void* datos, size_t largo);
+void Sha256_terminar(Sha256& s, uint8_t resumen[SHA256_LARGO]);
+
+// HMAC incremental (mismo uso que mbedtls_md_hmac_*)
+struct HmacSha256 {
+  uint8_t claveInterna[64];   // clave ^ ipad
+  uint8_t claveExterna[64];   // clave ^ opad
+  Sha256  interno;
+};
+
+void HmacSha256_iniciar(HmacSha256& h, const void* clave, size_t largoClave);
+void HmacSha256_reiniciar(HmacSha256& h);
+void HmacSha256_agregar(HmacSha256& h, const void* datos, size_t largo);
+void HmacSha256_terminar(HmacSha256& h, uint8_t mac[SHA256_LARGO]);
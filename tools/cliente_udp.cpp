@@ -0,0 +1,164 @@
+// =================================================================================
+// cliente_udp – CONSULTA, COMANDO Y BENCHMARK DEL PROTOCOLO UDP DESDE LINUX
+// =================================================================================
+//   cliente_udp [-p puerto] <ip> <clave> estado
+//   cliente_udp [-p puerto] <ip> <clave> pulso
+//   cliente_udp [-p puerto] <ip> <clave> bench [consultas]
+//   cliente_udp [-p puerto] [-g grupo] escuchar <clave>
+//
+// bench: consultas en serie (una en vuelo). Informa consultas/s y latencia
+// (p50 / p99 / máx). El jitter (p99 - p50) incluye WiFi, el loop() del equipo
+// y este host.
+// =================================================================================
+
+#include "ClienteUDP.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#define ESPERA_MS 500
+
+static const char* const nombresPorton[] = {
+  "desconocido", "cerrado", "abierto", "abriendo", "error sensores", "falla mecanica", "cerrando"
+};
+
+static const char* const nombresResultado[] = {
+  "aceptado", "duplicado", "viejo", "sesion distinta", "desconocido"
+};
+
+// =================================================================================
+// 1. HELPERS
+// =================================================================================
+static double usAhora() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void imprimirEstado(const TramaEstadoUDP& e) {
+  char usuario[sizeof(e.ultimoUsuario) + 1];
+  memcpy(usuario, e.ultimoUsuario, sizeof(e.ultimoUsuario));
+  usuario[sizeof(e.ultimoUsuario)] = '\0';
+
+  printf("sesion=%08x porton=%s seguridad=%u flags=0x%02x usuario=\"%s\" "
+         "ciclos=%u alarmas=%u uptime=%us\n",
+         e.cab.sesion,
+         e.estadoPorton < 7 ? nombresPorton[e.estadoPorton] : "?",
+         e.estadoSeguridad, e.flags, usuario, e.ciclos, e.alarmas, e.uptime);
+}
+
+static void uso() {
+  fprintf(stderr,
+          "uso: cliente_udp [-p puerto] <ip> <clave> estado|pulso|bench [n]\n"
+          "     cliente_udp [-p puerto] [-g grupo] escuchar <clave>\n");
+  exit(2);
+}
+
+// =================================================================================
+// 2. ÓRDENES
+// =================================================================================
+static int bench(ClienteUDP& c, int consultas) {
+
+  std::vector<double> latencias;
+  latencias.reserve(consultas);
+  int perdidas = 0;
+
+  double t0 = usAhora();
+  for (int i = 0; i < consultas; i++) {
+    TramaEstadoUDP e;
+    double t = usAhora();
+    if (ClienteUDP_consultar(c, e, ESPERA_MS)) latencias.push_back(usAhora() - t);
+    else                                        perdidas++;
+  }
+  double total = (usAhora() - t0) / 1e6;
+
+  if (latencias.empty()) {
+    fprintf(stderr, "sin respuestas\n");
+    return 1;
+  }
+
+  std::sort(latencias.begin(), latencias.end());
+  double p50 = latencias[latencias.size() / 2];
+  double p99 = latencias[latencias.size() * 99 / 100];
+
+  printf("%d consultas en %.2f s: %.0f consultas/s, %d sin respuesta\n",
+         consultas, total, latencias.size() / total, perdidas);
+  printf("latencia us: p50=%.0f p99=%.0f max=%.0f jitter(p99-p50)=%.0f\n",
+         p50, p99, latencias.back(), p99 - p50);
+  return perdidas ? 1 : 0;
+}
+
+static int escuchar(ClienteUDP& c) {
+  for (;;) {
+    uint8_t buf[64];
+    size_t n = ClienteUDP_recibir(c, buf, sizeof(buf), 60000);
+    if (n == sizeof(TramaEstadoUDP)) imprimirEstado(*(const TramaEstadoUDP*)buf);
+  }
+}
+
+// =================================================================================
+// 3. MAIN
+// =================================================================================
+int main(int argc, char** argv) {
+
+  uint16_t puerto = 4210;
+  uint16_t puertoGrupo = 4211;
+  const char* grupo = "239.255.42.1";
+
+  int i = 1;
+  for (; i < argc && argv[i][0] == '-'; i += 2) {
+    if (i + 1 >= argc) uso();
+    if      (strcmp(argv[i], "-p") == 0) puerto = puertoGrupo = (uint16_t)atoi(argv[i + 1]);
+    else if (strcmp(argv[i], "-g") == 0) grupo = argv[i + 1];
+    else uso();
+  }
+
+  ClienteUDP c;
+
+  if (argc - i == 2 && strcmp(argv[i], "escuchar") == 0) {
+    if (!ClienteUDP_abrir(c, "0.0.0.0", 0, argv[i + 1]) ||
+        !ClienteUDP_unirseGrupo(c, grupo, puertoGrupo)) {
+      perror("escuchar");
+      return 1;
+    }
+    return escuchar(c);
+  }
+
+  if (argc - i < 3) uso();
+  if (!ClienteUDP_abrir(c, argv[i], puerto, argv[i + 1])) {
+    fprintf(stderr, "ip invalida: %s\n", argv[i]);
+    return 1;
+  }
+  const char* orden = argv[i + 2];
+
+  if (strcmp(orden, "estado") == 0) {
+    TramaEstadoUDP e;
+    if (!ClienteUDP_consultar(c, e, ESPERA_MS)) {
+      fprintf(stderr, "sin respuesta\n");
+      return 1;
+    }
+    imprimirEstado(e);
+    return 0;
+  }
+
+  if (strcmp(orden, "pulso") == 0) {
+    ResultadoUDP r;
+    if (!ClienteUDP_pulso(c, r, ESPERA_MS)) {
+      fprintf(stderr, "sin respuesta\n");
+      return 1;
+    }
+    printf("%s\n", r <= UDP_ACK_DESCONOCIDO ? nombresResultado[r] : "?");
+    return (r == UDP_ACK_ACEPTADO || r == UDP_ACK_DUPLICADO) ? 0 : 1;
+  }
+
+  if (strcmp(orden, "bench") == 0) {
+    int n = (argc - i > 3) ? atoi(argv[i + 3]) : 1000;
+    return bench(c, n > 0 ? n : 1000);
+  }
+
+  uso();
+}